@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * Benchmarks of the lexer, the parser, type unification, and whole-program
+ * reading, over synthetic corpora. Run with `cargo bench`.
+ */
+
+use std::fmt::Write;
+use std::path::PathBuf;
+
+use criterion::{criterion_group, criterion_main, BatchSize, Criterion, Throughput};
+
+use syscraws::backend::ty::{TyArena, TyNode};
+use syscraws::backend::TyConstructor;
+use syscraws::frontend;
+use syscraws::frontend::ast;
+use syscraws::frontend::chars_peekable::CharsPeekable;
+
+/**
+ * A token-dense input: many short statements mixing identifiers, numeric
+ * literals, operators and string literals.
+ */
+fn lexer_corpus(num_lines: usize) -> String {
+    let mut corpus = String::new();
+    for i in 0..num_lines {
+        writeln!(
+            corpus,
+            "value{i} = value{i} + {i}.5 - \"line {i}\".len",
+            i = i
+        )
+        .unwrap();
+    }
+    corpus
+}
+
+/**
+ * One statement whose expression nests `depth` levels of parentheses.
+ */
+fn deep_expression(depth: usize) -> String {
+    let mut corpus = String::new();
+    for _ in 0..depth {
+        corpus.push('(');
+    }
+    corpus.push('1');
+    for _ in 0..depth {
+        corpus.push(')');
+    }
+    corpus.push('\n');
+    corpus
+}
+
+/**
+ * A flat file defining `count` small functions, exercising
+ * `register_function_name`-heavy inputs.
+ */
+fn wide_functions(count: usize) -> String {
+    let mut corpus = String::new();
+    for i in 0..count {
+        writeln!(corpus, "func f{i}(x: int): int\n    x\nend", i = i).unwrap();
+    }
+    corpus
+}
+
+/**
+ * Writes a chain of `length` files, each importing the next, into a
+ * temporary directory, and returns the path of the first.
+ */
+fn import_chain(length: usize) -> PathBuf {
+    let directory = std::env::temp_dir().join("syscraws-bench-import-chain");
+    std::fs::create_dir_all(&directory).unwrap();
+    for i in 0..length {
+        let mut content = String::new();
+        if i + 1 < length {
+            writeln!(content, "import file{}", i + 1).unwrap();
+        }
+        writeln!(content, "func f{i}(x: int): int\n    x\nend", i = i).unwrap();
+        std::fs::write(directory.join(format!("file{}.sysc", i)), content).unwrap();
+    }
+    directory.join("file0.sysc")
+}
+
+fn bench_lexer(c: &mut Criterion) {
+    let input = lexer_corpus(10_000);
+    let mut group = c.benchmark_group("lexer");
+    group.throughput(Throughput::Bytes(input.len() as u64));
+    group.bench_function("count_tokens", |b| {
+        b.iter(|| {
+            let mut chars_peekable = CharsPeekable::new(&input);
+            ast::count_tokens(&mut chars_peekable).unwrap()
+        })
+    });
+    group.finish();
+}
+
+fn bench_parser(c: &mut Criterion) {
+    let mut group = c.benchmark_group("parser");
+    for (name, input) in [
+        ("deep_expression", deep_expression(256)),
+        ("wide_functions", wide_functions(2_000)),
+    ] {
+        group.throughput(Throughput::Bytes(input.len() as u64));
+        group.bench_function(name, |b| {
+            b.iter(|| {
+                let mut chars_peekable = CharsPeekable::new(&input);
+                ast::parse_file(&mut chars_peekable).unwrap()
+            })
+        });
+    }
+    group.finish();
+}
+
+/**
+ * Builds two lists of `depth` `Cons` cells: one all undetermined, one all
+ * integers. Unifying them binds every undetermined node.
+ */
+fn deep_cons_lists(
+    depth: usize,
+) -> (
+    TyArena,
+    syscraws::backend::ty::TyId,
+    syscraws::backend::ty::TyId,
+) {
+    let mut arena = TyArena::new();
+    let mut left = arena.push(TyNode::Nil);
+    let mut right = arena.push(TyNode::Nil);
+    for _ in 0..depth {
+        let head = arena.push_undetermined();
+        left = arena.push(TyNode::Cons(head, left));
+        let head = arena.push(TyNode::Constructor(TyConstructor::Integer));
+        right = arena.push(TyNode::Cons(head, right));
+    }
+    (arena, left, right)
+}
+
+fn bench_unify(c: &mut Criterion) {
+    let mut group = c.benchmark_group("unify");
+    group.bench_function("deep_cons", |b| {
+        b.iter_batched(
+            || deep_cons_lists(1_000),
+            |(mut arena, left, right)| {
+                let mut trail = Vec::new();
+                let snapshot = arena.snapshot(&trail);
+                assert!(arena.unify(left, right, &mut trail));
+                arena.rollback(&mut trail, snapshot);
+            },
+            BatchSize::SmallInput,
+        )
+    });
+    group.finish();
+}
+
+fn bench_read_input(c: &mut Criterion) {
+    let root = import_chain(64);
+    let remove_modules = || {
+        for i in 0..64 {
+            std::fs::remove_file(root.with_file_name(format!("file{}.syscm", i))).ok();
+        }
+    };
+    let mut group = c.benchmark_group("read_input");
+    group.bench_function("import_chain_cold", |b| {
+        b.iter(|| {
+            remove_modules();
+            frontend::read_input(&root).unwrap()
+        })
+    });
+    group.bench_function("import_chain_warm", |b| {
+        frontend::read_input(&root).unwrap();
+        b.iter(|| frontend::read_input(&root).unwrap())
+    });
+    group.finish();
+}
+
+criterion_group!(
+    benches,
+    bench_lexer,
+    bench_parser,
+    bench_unify,
+    bench_read_input
+);
+criterion_main!(benches);
@@ -16,54 +16,118 @@
  * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
  */
 
-use std::{cell::RefCell, collections::HashMap, rc::Rc};
+pub mod code;
+pub mod escape;
+pub mod fold;
+pub mod hoist;
+pub mod inline;
+pub mod layout;
+pub mod resolve;
+pub mod ty;
+pub mod value;
+
+use std::sync::OnceLock;
+
+use ty::{TrailEntry, TyArena, TyId, TyNode};
 
 pub struct Definitions {
-    pub tys_kind: HashMap<TyConstructor, TyKind>,
+    /**
+     * The kind of each structure, indexed like
+     * [`structures`](Self::structures). Kinds of the builtin type
+     * constructors live in the process-wide table consulted by
+     * [`ty_kind`](Self::ty_kind) and are not stored here.
+     */
+    pub structure_kinds: Vec<TyKind>,
+    /**
+     * The field types of every structure, consulted when a field access is
+     * translated and when [`layout`] computes word offsets. The kinds
+     * scanned during unification live in
+     * [`structure_kinds`](Self::structure_kinds) instead.
+     */
     pub structures: Vec<Structure>,
-    pub functions: Vec<(FunctionTy, FunctionDefinition)>,
+    /**
+     * The signature of every function, indexed like
+     * [`function_definitions`](Self::function_definitions). Signatures are
+     * scanned once per call site during overload resolution, so they form
+     * their own dense table: walking it does not drag function bodies
+     * through the cache.
+     */
+    pub function_tys: Vec<FunctionTy>,
+    /**
+     * The body of every function, indexed like
+     * [`function_tys`](Self::function_tys) and touched only by the
+     * optimization passes and by [`code`] lowering.
+     */
+    pub function_definitions: Vec<FunctionDefinition>,
     pub num_global_variables: usize,
 }
 
 impl Definitions {
-    pub fn builtin() -> Definitions {
+    pub fn new() -> Definitions {
         Definitions {
-            tys_kind: HashMap::from([
-                (TyConstructor::Integer, TyKind::Ty),
-                (TyConstructor::Float, TyKind::Ty),
-                (
-                    TyConstructor::Reference,
-                    TyKind::Abstraction {
-                        parameters: TyListKind::Cons(
-                            Box::new(TyKind::Ty),
-                            Box::new(TyListKind::Nil),
-                        ),
-                        ret: Box::new(TyKind::Ty),
-                    },
-                ),
-                (
-                    TyConstructor::Tuple,
-                    TyKind::Abstraction {
-                        parameters: TyListKind::Rest,
-                        ret: Box::new(TyKind::Ty),
-                    },
-                ),
-                (
-                    TyConstructor::Function,
-                    TyKind::Abstraction {
-                        parameters: TyListKind::Cons(
-                            Box::new(TyKind::Ty),
-                            Box::new(TyListKind::Rest),
-                        ),
-                        ret: Box::new(TyKind::Ty),
-                    },
-                ),
-            ]),
+            structure_kinds: Vec::new(),
             structures: Vec::new(),
-            functions: Vec::new(),
+            function_tys: Vec::new(),
+            function_definitions: Vec::new(),
             num_global_variables: 0,
         }
     }
+    /**
+     * Appends a function, keeping the signature table and the body table
+     * aligned.
+     */
+    pub fn push_function(&mut self, ty: FunctionTy, definition: FunctionDefinition) {
+        self.function_tys.push(ty);
+        self.function_definitions.push(definition);
+    }
+    /**
+     * Returns the kind of `constructor`: an array lookup in the builtin
+     * table for the builtin constructors, an index into
+     * [`structure_kinds`](Self::structure_kinds) for structures.
+     */
+    pub fn ty_kind(&self, constructor: &TyConstructor) -> &TyKind {
+        match *constructor {
+            TyConstructor::Structure(index) => &self.structure_kinds[index],
+            ref constructor => &builtin_tys_kind()[constructor.builtin_index()],
+        }
+    }
+}
+
+impl Default for Definitions {
+    fn default() -> Definitions {
+        Definitions::new()
+    }
+}
+
+/**
+ * The kinds of the builtin type constructors, indexed by
+ * [`TyConstructor::builtin_index`]. Built once per process, on first use.
+ */
+fn builtin_tys_kind() -> &'static [TyKind; 5] {
+    static BUILTIN_TYS_KIND: OnceLock<[TyKind; 5]> = OnceLock::new();
+    BUILTIN_TYS_KIND.get_or_init(|| {
+        [
+            // Integer
+            TyKind::Ty,
+            // Float
+            TyKind::Ty,
+            // Reference
+            TyKind::Abstraction {
+                parameters: TyListKind::Cons(Box::new(TyKind::Ty), Box::new(TyListKind::Nil)),
+                ret: Box::new(TyKind::Ty),
+            },
+            // Tuple
+            TyKind::Abstraction {
+                parameters: TyListKind::Rest,
+                ret: Box::new(TyKind::Ty),
+            },
+            // Function
+            TyKind::Abstraction {
+                parameters: TyListKind::Cons(Box::new(TyKind::Ty), Box::new(TyListKind::Rest)),
+                ret: Box::new(TyKind::Ty),
+            },
+        ]
+    })
 }
 
 pub struct Structure {
@@ -81,6 +145,11 @@ pub struct FunctionTy {
 pub enum Function {
     IAdd,
     Deref,
+    /**
+     * Writes its second argument through the reference given as its first
+     * argument and evaluates to the written value.
+     */
+    Assign,
     UserDefined(usize),
     Field {
         structure_index: usize,
@@ -117,6 +186,25 @@ pub enum TyConstructor {
     Structure(usize),
 }
 
+impl TyConstructor {
+    /**
+     * The index of a builtin constructor in the table returned by
+     * [`builtin_tys_kind`]. Must not be called on
+     * [`Structure`](Self::Structure), whose kind is stored per program in
+     * [`Definitions::structure_kinds`].
+     */
+    fn builtin_index(&self) -> usize {
+        match self {
+            TyConstructor::Integer => 0,
+            TyConstructor::Float => 1,
+            TyConstructor::Reference => 2,
+            TyConstructor::Tuple => 3,
+            TyConstructor::Function => 4,
+            TyConstructor::Structure(_) => unreachable!(),
+        }
+    }
+}
+
 pub enum TyKind {
     Ty,
     Abstraction {
@@ -131,111 +219,23 @@ pub enum TyListKind {
     Rest,
 }
 
-#[derive(Clone)]
-struct Ty {
-    inner: Rc<RefCell<TyInner>>,
-}
-
-enum TyInner {
-    Constructor(TyConstructor),
-    Parameter(usize),
-    Application { constructor: Ty, arguments: Ty },
-    Nil,
-    Cons(Ty, Ty),
-    Undetermined,
-    SameAs(Ty),
-}
-
-impl Ty {
-    fn contains(&self, other: &Ty) -> bool {
-        if Rc::ptr_eq(&self.inner, &other.inner) {
-            return true;
-        }
-        match &*self.inner.borrow() {
-            TyInner::Constructor(_) => false,
-            TyInner::Parameter(_) => false,
-            TyInner::Application {
-                constructor,
-                arguments,
-            } => constructor.contains(other) || arguments.contains(other),
-            TyInner::Nil => false,
-            TyInner::Cons(head, tail) => head.contains(other) || tail.contains(other),
-            TyInner::Undetermined => false,
-            TyInner::SameAs(this) => this.contains(other),
-        }
-    }
-
-    fn unify(&self, other: &Ty, history: &mut Vec<Ty>) -> bool {
-        let self_binding = self.inner.borrow();
-        let other_binding = other.inner.borrow();
-        match (&*self_binding, &*other_binding) {
-            (TyInner::SameAs(self_), _) => {
-                drop(other_binding);
-                self_.unify(other, history)
-            }
-            (_, TyInner::SameAs(other_)) => {
-                drop(self_binding);
-                self.unify(other_, history)
-            }
-            (TyInner::Undetermined, _) => {
-                if other.contains(self) {
-                    return false;
-                }
-                drop(self_binding);
-                history.push(self.clone());
-                *self.inner.borrow_mut() = TyInner::SameAs(other.clone());
-                true
-            }
-            (_, TyInner::Undetermined) => {
-                if self.contains(other) {
-                    return false;
-                }
-                drop(other_binding);
-                history.push(other.clone());
-                *other.inner.borrow_mut() = TyInner::SameAs(self.clone());
-                true
-            }
-            (TyInner::Constructor(self_constructor), TyInner::Constructor(other_constructor)) => {
-                self_constructor == other_constructor
-            }
-            (TyInner::Parameter(self_index), TyInner::Parameter(other_index)) => {
-                self_index == other_index
-            }
-            (TyInner::Nil, TyInner::Nil) => true,
-            (TyInner::Cons(self_head, self_tail), TyInner::Cons(other_head, other_tail)) => {
-                self_head.unify(other_head, history) && self_tail.unify(other_tail, history)
-            }
-            (
-                TyInner::Application {
-                    constructor: self_constructor,
-                    arguments: self_arguments,
-                },
-                TyInner::Application {
-                    constructor: other_constructor,
-                    arguments: other_arguments,
-                },
-            ) => {
-                self_constructor.unify(other_constructor, history)
-                    && self_arguments.unify(other_arguments, history)
-            }
-            _ => false,
-        }
-    }
-}
-
-fn rollback(history: &[Ty]) {
-    for ty in history {
-        *ty.inner.borrow_mut() = TyInner::Undetermined
-    }
-}
-
 pub enum Statement {
     Empty,
     Expr(Expression),
     While(Expression, Vec<Statement>),
+    /**
+     * Evaluates the expression and stores the result into the local
+     * variable with the given index. Translation does not produce this
+     * directly — assignments in source are overloaded function calls — but
+     * optimization passes use it to materialize a value once, such as a
+     * loop-invariant chain hoisted by [`hoist`].
+     */
+    Let(usize, Expression),
 }
 
 pub enum Expression {
+    Integer(i64),
+    Float(f64),
     GlobalVariable(usize),
     LocalVariable(usize),
     Function {
@@ -251,94 +251,199 @@ pub struct Call {
 }
 
 impl FunctionTy {
-    fn build(&self) -> Ty {
+    fn build(&self, arena: &mut TyArena) -> TyId {
         let ty_parameters: Vec<_> = (0..self.num_ty_parameters)
-            .map(|_| Ty {
-                inner: Rc::new(RefCell::new(TyInner::Undetermined)),
-            })
+            .map(|_| arena.push_undetermined())
             .collect();
-        let mut arguments = Ty {
-            inner: Rc::new(RefCell::new(TyInner::Nil)),
-        };
+        let mut arguments = arena.push(TyNode::Nil);
         for ty in self.parameters_ty.iter().rev() {
-            arguments = Ty {
-                inner: Rc::new(RefCell::new(TyInner::Cons(
-                    ty.build(&ty_parameters),
-                    arguments,
-                ))),
-            };
-        }
-        let arguments = Ty {
-            inner: Rc::new(RefCell::new(TyInner::Cons(
-                self.return_ty.build(&ty_parameters),
-                arguments,
-            ))),
-        };
-        Ty {
-            inner: Rc::new(RefCell::new(TyInner::Application {
-                constructor: Ty {
-                    inner: Rc::new(RefCell::new(TyInner::Constructor(TyConstructor::Function))),
-                },
-                arguments,
-            })),
+            let head = ty.build(arena, &ty_parameters);
+            arguments = arena.push(TyNode::Cons(head, arguments));
         }
+        let return_ty = self.return_ty.build(arena, &ty_parameters);
+        let arguments = arena.push(TyNode::Cons(return_ty, arguments));
+        let constructor = arena.push(TyNode::Constructor(TyConstructor::Function));
+        arena.push(TyNode::Application {
+            constructor,
+            arguments,
+        })
     }
 }
 
 impl TyBuilder {
-    fn build(&self, parameters: &[Ty]) -> Ty {
+    fn build(&self, arena: &mut TyArena, parameters: &[TyId]) -> TyId {
         match *self {
-            TyBuilder::Constructor(ref constructor) => Ty {
-                inner: Rc::new(RefCell::new(TyInner::Constructor(constructor.clone()))),
-            },
+            TyBuilder::Constructor(ref constructor) => {
+                arena.push(TyNode::Constructor(constructor.clone()))
+            }
             TyBuilder::Application {
                 ref constructor,
                 ref arguments,
-            } => Ty {
-                inner: Rc::new(RefCell::new(TyInner::Application {
-                    constructor: constructor.build(parameters),
-                    arguments: arguments.iter().rev().fold(
-                        Ty {
-                            inner: Rc::new(RefCell::new(TyInner::Nil)),
-                        },
-                        |tail, head| Ty {
-                            inner: Rc::new(RefCell::new(TyInner::Cons(
-                                head.build(parameters),
-                                tail,
-                            ))),
-                        },
-                    ),
-                })),
-            },
-            TyBuilder::Parameter(index) => parameters[index].clone(),
+            } => {
+                let constructor = constructor.build(arena, parameters);
+                let mut tail = arena.push(TyNode::Nil);
+                for argument in arguments.iter().rev() {
+                    let head = argument.build(arena, parameters);
+                    tail = arena.push(TyNode::Cons(head, tail));
+                }
+                arena.push(TyNode::Application {
+                    constructor,
+                    arguments: tail,
+                })
+            }
+            TyBuilder::Parameter(index) => parameters[index],
         }
     }
 }
 
-fn get_function_ty(
-    function: &Function,
-    function_definition: &[(FunctionTy, FunctionDefinition)],
-) -> Ty {
+fn get_function_ty(function: &Function, function_tys: &[FunctionTy], arena: &mut TyArena) -> TyId {
     match *function {
-        Function::UserDefined(index) => function_definition[index].0.build(),
+        Function::UserDefined(index) => function_tys[index].build(arena),
         _ => todo!(),
     }
 }
 
-fn get_ty(expression: &Expression, function_definition: &[(FunctionTy, FunctionDefinition)]) {
+/**
+ * A compact summary of one function candidate's type: its arity and the
+ * head constructor of each parameter type. Checking a signature against a
+ * call rejects most overload candidates without building a single type
+ * node, leaving full `unify`-and-`rollback` for the survivors.
+ */
+struct Signature {
+    arity: usize,
+    parameter_heads: Vec<Option<TyConstructor>>,
+}
+
+impl Signature {
+    fn of(ty: &FunctionTy) -> Signature {
+        Signature {
+            arity: ty.parameters_ty.len(),
+            parameter_heads: ty.parameters_ty.iter().map(head_constructor).collect(),
+        }
+    }
+    /**
+     * Whether `call` could possibly type-check against this signature: the
+     * argument count matches, and no argument whose head constructor is
+     * known up front contradicts the parameter's.
+     */
+    fn matches(&self, call: &Call) -> bool {
+        if call.arguments.len() != self.arity {
+            return false;
+        }
+        call.arguments
+            .iter()
+            .zip(&self.parameter_heads)
+            .all(
+                |(argument, parameter_head)| match (argument_head(argument), parameter_head) {
+                    (Some(argument_head), Some(parameter_head)) => argument_head == *parameter_head,
+                    _ => true,
+                },
+            )
+    }
+}
+
+/**
+ * The head constructor of `ty`, or `None` if it depends on a type
+ * parameter.
+ */
+fn head_constructor(ty: &TyBuilder) -> Option<TyConstructor> {
+    match ty {
+        TyBuilder::Constructor(constructor) => Some(constructor.clone()),
+        TyBuilder::Parameter(_) => None,
+        TyBuilder::Application { constructor, .. } => head_constructor(constructor),
+    }
+}
+
+/**
+ * The head constructor of the type of `argument`, when it is known without
+ * any type checking.
+ */
+fn argument_head(argument: &Expression) -> Option<TyConstructor> {
+    match argument {
+        Expression::Integer(_) => Some(TyConstructor::Integer),
+        Expression::Float(_) => Some(TyConstructor::Float),
+        _ => None,
+    }
+}
+
+/**
+ * Computes the [`Signature`] of every function in `function_tys`, indexed
+ * like [`Function::UserDefined`]. Computed once per program, not per call
+ * site.
+ */
+fn candidate_signatures(function_tys: &[FunctionTy]) -> Vec<Signature> {
+    function_tys.iter().map(Signature::of).collect()
+}
+
+/**
+ * The [`Signature`] of a builtin candidate, or `None` for builtins whose
+ * parameter types depend on context.
+ */
+fn builtin_signature(function: &Function) -> Option<Signature> {
+    match function {
+        Function::IAdd => Some(Signature {
+            arity: 2,
+            parameter_heads: vec![Some(TyConstructor::Integer), Some(TyConstructor::Integer)],
+        }),
+        Function::Deref => Some(Signature {
+            arity: 1,
+            parameter_heads: vec![Some(TyConstructor::Reference)],
+        }),
+        Function::Assign => Some(Signature {
+            arity: 2,
+            parameter_heads: vec![Some(TyConstructor::Reference), None],
+        }),
+        Function::Field { .. } | Function::FieldRef { .. } => Some(Signature {
+            arity: 1,
+            parameter_heads: vec![None],
+        }),
+        Function::UserDefined(_) => None,
+    }
+}
+
+fn get_ty(
+    expression: &Expression,
+    function_tys: &[FunctionTy],
+    signatures: &[Signature],
+    arena: &mut TyArena,
+    trail: &mut Vec<TrailEntry>,
+) {
     match expression {
         Expression::Function { candidates, calls } => {
             for candidate in candidates {
-                let ty = get_function_ty(candidate, function_definition);
+                // Reject the candidate by its signature alone if the first
+                // call cannot possibly match it.
+                let signature = match *candidate {
+                    Function::UserDefined(index) => Some(&signatures[index]),
+                    _ => None,
+                };
+                let builtin;
+                let signature = match signature {
+                    Some(signature) => Some(signature),
+                    None => {
+                        builtin = builtin_signature(candidate);
+                        builtin.as_ref()
+                    }
+                };
+                if let (Some(signature), Some(call)) = (signature, calls.first()) {
+                    if !signature.matches(call) {
+                        continue;
+                    }
+                }
+                let ty = get_function_ty(candidate, function_tys, arena);
                 for call in calls {
-                    match *ty.inner.borrow() {
-                        TyInner::Application {
-                            ref constructor,
-                            ref arguments,
-                        } => match *constructor.inner.borrow() {
-                            TyInner::Constructor(TyConstructor::Function) => {}
-                            _ => todo!(),
-                        },
+                    let ty = arena.find(ty, trail);
+                    match *arena.node(ty) {
+                        TyNode::Application {
+                            constructor,
+                            arguments,
+                        } => {
+                            let constructor = arena.find(constructor, trail);
+                            match *arena.node(constructor) {
+                                TyNode::Constructor(TyConstructor::Function) => {}
+                                _ => todo!(),
+                            }
+                        }
                         _ => todo!(),
                     }
                 }
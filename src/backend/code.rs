@@ -0,0 +1,552 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * Defines the bytecode representation of translated functions and the
+ * interpreter that executes it.
+ *
+ * A [`FunctionDefinition`](super::FunctionDefinition) body is a tree of
+ * [`Statement`](super::Statement)s and [`Expression`](super::Expression)s.
+ * Walking that tree on every call would require a match on a boxed enum per
+ * node, so [`lower_function`] flattens each body once into a contiguous
+ * [`Vec<Instruction>`] which [`run`] executes with a stack-based dispatch
+ * loop. Frequent operations such as [`Function::IAdd`](super::Function),
+ * [`Function::Deref`](super::Function) and
+ * [`Function::Field`](super::Function) become single opcodes. Every
+ * operand is a one-word NaN-boxed [`Value`]; tuples and structures live
+ * in [`Heap`] cells behind references.
+ */
+
+mod tests;
+
+use super::escape;
+use super::layout::{self, Layout};
+use super::value::{self, Heap, Value};
+use super::{Call, Definitions, Expression, Function, FunctionDefinition, Statement};
+
+/**
+ * A single bytecode instruction.
+ *
+ * Instructions operate on an operand stack of [`Value`]s. Jump targets are
+ * absolute indices into the instruction array of the containing
+ * [`CodeFunction`].
+ */
+#[derive(Clone, Debug, PartialEq)]
+pub enum Instruction {
+    /**
+     * Pushes an integer constant.
+     */
+    PushInteger(i64),
+    /**
+     * Pushes a floating-point constant.
+     */
+    PushFloat(f64),
+    /**
+     * Pushes a reference to the global variable with the given index.
+     */
+    PushGlobalRef(usize),
+    /**
+     * Pushes a reference to the local variable with the given index,
+     * relative to the current frame.
+     */
+    PushLocalRef(usize),
+    /**
+     * Pops a reference and pushes the value it refers to.
+     */
+    Deref,
+    /**
+     * Pops two integers and pushes their sum.
+     */
+    IAdd,
+    /**
+     * Pops a structure value — a reference to its cell — and pushes the
+     * `size` words starting at word `offset`, as resolved by the
+     * structure's [`Layout`](layout::Layout): the word itself when `size`
+     * is one, a reference to a fresh cell holding a copy otherwise.
+     */
+    Field { offset: usize, size: usize },
+    /**
+     * Pops a reference to a place holding a structure value and pushes a
+     * reference to the `size` words starting at word `offset` of the
+     * structure's cell.
+     */
+    FieldRef { offset: usize, size: usize },
+    /**
+     * Pushes the `size` words starting at word `offset` of the tuple held
+     * in the local variable with the given frame-relative index, reading
+     * the tuple in place instead of materializing a copy of it first.
+     * Emitted only for locals that [`escape`] proves never leave the
+     * function, so the in-place read cannot observe a slot some alias is
+     * rebinding.
+     */
+    FieldOfLocal {
+        index: usize,
+        offset: usize,
+        size: usize,
+    },
+    /**
+     * Calls the function with the given index in
+     * [`Definitions::function_definitions`]. The `num_arguments` topmost
+     * stack values become the first locals of the new frame.
+     */
+    Call {
+        function_index: usize,
+        num_arguments: usize,
+    },
+    /**
+     * Pops a value and stores it into the local variable with the given
+     * index, relative to the current frame.
+     */
+    StoreLocal(usize),
+    /**
+     * Pops a value, then a reference, writes the value through the
+     * reference, and pushes the value back: an assignment statement then
+     * drops it like any other expression result.
+     */
+    Store,
+    /**
+     * Pops and discards the top of the stack.
+     */
+    Drop,
+    /**
+     * Jumps to the given instruction index.
+     */
+    Jump(usize),
+    /**
+     * Pops an integer and jumps to the given instruction index if it is
+     * zero.
+     */
+    JumpIfZero(usize),
+    /**
+     * Returns from the current function: takes this frame's return value —
+     * the single operand the body left above the frame's stack base, or
+     * the empty tuple if it left none — discards the rest of the frame's
+     * operands, and pushes the value onto the caller's stack.
+     */
+    Return,
+}
+
+/**
+ * A function body lowered to a flat instruction array.
+ */
+pub struct CodeFunction {
+    pub num_local_variables: usize,
+    pub instructions: Vec<Instruction>,
+}
+
+/**
+ * An error found while lowering a body to bytecode.
+ */
+#[derive(Debug, PartialEq)]
+pub enum LowerError {
+    /**
+     * A call reached lowering with other than exactly one candidate and
+     * one argument list: overload resolution left it ambiguous or
+     * unresolved, which the caller reports as a diagnostic.
+     */
+    UnresolvedCall,
+    /**
+     * A structure layout could not be computed; see
+     * [`layout::LayoutError`].
+     */
+    Layout(layout::LayoutError),
+}
+
+/**
+ * Lowers every function body in `definitions` into bytecode.
+ */
+pub fn lower(definitions: &Definitions) -> Result<Vec<CodeFunction>, LowerError> {
+    let layouts = layout::layouts(definitions).map_err(LowerError::Layout)?;
+    definitions
+        .function_definitions
+        .iter()
+        .map(|definition| lower_function(definition, &layouts))
+        .collect()
+}
+
+/**
+ * Lowers a single function body into a [`CodeFunction`]. `layouts` holds
+ * the precomputed [`Layout`] of each structure, indexed like
+ * [`Definitions::structures`]. Field reads of locals that
+ * [`escape::escaping_locals`] proves never leave the function are fused
+ * into [`Instruction::FieldOfLocal`], so a short-lived tuple in a frame
+ * slot is read in place instead of being copied out first. Statement
+ * results are dropped, except that a trailing expression statement keeps
+ * its value on the stack as the function's return value.
+ */
+pub fn lower_function(
+    definition: &FunctionDefinition,
+    layouts: &[Option<Layout>],
+) -> Result<CodeFunction, LowerError> {
+    let escaping = escape::escaping_locals(definition);
+    let mut instructions = Vec::new();
+    if let [rest @ .., last] = definition.body.as_slice() {
+        for statement in rest {
+            lower_statement(statement, layouts, &escaping, &mut instructions)?;
+        }
+        // The value of a trailing expression statement is the return value.
+        if let Statement::Expr(expression) = last {
+            lower_expression(expression, layouts, &escaping, &mut instructions)?;
+        } else {
+            lower_statement(last, layouts, &escaping, &mut instructions)?;
+        }
+    }
+    instructions.push(Instruction::Return);
+    Ok(CodeFunction {
+        num_local_variables: definition.num_local_variables,
+        instructions,
+    })
+}
+
+fn lower_statement(
+    statement: &Statement,
+    layouts: &[Option<Layout>],
+    escaping: &[bool],
+    instructions: &mut Vec<Instruction>,
+) -> Result<(), LowerError> {
+    match statement {
+        Statement::Empty => {}
+        Statement::Expr(expression) => {
+            lower_expression(expression, layouts, escaping, instructions)?;
+            instructions.push(Instruction::Drop);
+        }
+        Statement::While(condition, body) => {
+            let condition_start = instructions.len();
+            lower_expression(condition, layouts, escaping, instructions)?;
+            let exit_jump = instructions.len();
+            // The target is patched below, once the body length is known.
+            instructions.push(Instruction::JumpIfZero(usize::MAX));
+            for statement in body {
+                lower_statement(statement, layouts, escaping, instructions)?;
+            }
+            instructions.push(Instruction::Jump(condition_start));
+            let after_loop = instructions.len();
+            instructions[exit_jump] = Instruction::JumpIfZero(after_loop);
+        }
+        Statement::Let(index, expression) => {
+            lower_expression(expression, layouts, escaping, instructions)?;
+            instructions.push(Instruction::StoreLocal(*index));
+        }
+    }
+    Ok(())
+}
+
+fn lower_expression(
+    expression: &Expression,
+    layouts: &[Option<Layout>],
+    escaping: &[bool],
+    instructions: &mut Vec<Instruction>,
+) -> Result<(), LowerError> {
+    match expression {
+        Expression::Integer(value) => instructions.push(Instruction::PushInteger(*value)),
+        Expression::Float(value) => instructions.push(Instruction::PushFloat(*value)),
+        Expression::GlobalVariable(index) => instructions.push(Instruction::PushGlobalRef(*index)),
+        Expression::LocalVariable(index) => instructions.push(Instruction::PushLocalRef(*index)),
+        Expression::Function { candidates, calls } => {
+            // Lowering requires overload resolution to have left exactly one
+            // candidate.
+            let [function] = &candidates[..] else {
+                return Err(LowerError::UnresolvedCall);
+            };
+            let [call] = &calls[..] else {
+                return Err(LowerError::UnresolvedCall);
+            };
+            lower_call(function, call, layouts, escaping, instructions)?;
+        }
+    }
+    Ok(())
+}
+
+fn lower_call(
+    function: &Function,
+    call: &Call,
+    layouts: &[Option<Layout>],
+    escaping: &[bool],
+    instructions: &mut Vec<Instruction>,
+) -> Result<(), LowerError> {
+    if let Function::Field {
+        structure_index,
+        field_index,
+    } = *function
+    {
+        if let [argument] = call.arguments.as_slice() {
+            if let Some(index) = deref_of_unescaping_local(argument, escaping) {
+                let (offset, size) = field_word_range(layouts, structure_index, field_index);
+                instructions.push(Instruction::FieldOfLocal {
+                    index,
+                    offset,
+                    size,
+                });
+                return Ok(());
+            }
+        }
+    }
+    for argument in &call.arguments {
+        lower_expression(argument, layouts, escaping, instructions)?;
+    }
+    match *function {
+        Function::IAdd => instructions.push(Instruction::IAdd),
+        Function::Deref => instructions.push(Instruction::Deref),
+        Function::Assign => instructions.push(Instruction::Store),
+        Function::Field {
+            structure_index,
+            field_index,
+        } => {
+            let (offset, size) = field_word_range(layouts, structure_index, field_index);
+            instructions.push(Instruction::Field { offset, size })
+        }
+        Function::FieldRef {
+            structure_index,
+            field_index,
+        } => {
+            let (offset, size) = field_word_range(layouts, structure_index, field_index);
+            instructions.push(Instruction::FieldRef { offset, size })
+        }
+        Function::UserDefined(function_index) => instructions.push(Instruction::Call {
+            function_index,
+            num_arguments: call.arguments.len(),
+        }),
+    }
+    Ok(())
+}
+
+/**
+ * The local index when `expression` is a [`Function::Deref`] of a local
+ * variable that does not escape, making the field read fusable into
+ * [`Instruction::FieldOfLocal`].
+ */
+fn deref_of_unescaping_local(expression: &Expression, escaping: &[bool]) -> Option<usize> {
+    let Expression::Function { candidates, calls } = expression else {
+        return None;
+    };
+    let [Function::Deref] = candidates.as_slice() else {
+        return None;
+    };
+    let [call] = calls.as_slice() else {
+        return None;
+    };
+    let [Expression::LocalVariable(index)] = call.arguments.as_slice() else {
+        return None;
+    };
+    (!escaping[*index]).then_some(*index)
+}
+
+/**
+ * The word offset and size of a field, read from the precomputed
+ * [`Layout`] of its structure.
+ */
+fn field_word_range(
+    layouts: &[Option<Layout>],
+    structure_index: usize,
+    field_index: usize,
+) -> (usize, usize) {
+    match layouts.get(structure_index).and_then(Option::as_ref) {
+        Some(layout) => (
+            layout.field_offsets[field_index],
+            layout.field_sizes[field_index],
+        ),
+        // A generic structure keeps one boxed word per field until
+        // monomorphization computes its instantiation layouts.
+        None => (field_index, 1),
+    }
+}
+
+/**
+ * A call frame of [`run`].
+ */
+struct Frame {
+    function_index: usize,
+    /**
+     * The index of the next instruction to execute.
+     */
+    counter: usize,
+    /**
+     * The frame's local variable slots. They are their own allocation, so
+     * references into them stay valid while the frame is suspended behind
+     * further calls.
+     */
+    locals: value::Frame,
+    /**
+     * The operand stack depth when this frame was entered. The frame's own
+     * operands live above it, so a callee cannot take an operand the
+     * caller left pending, and [`Instruction::Return`] cuts back to it.
+     */
+    stack_base: usize,
+}
+
+/**
+ * Executes the function with index `function_index`, passing `arguments` as
+ * its first local variables, and returns its result. Structure values are
+ * references to cells of `heap`, which keeps alive every cell the
+ * execution allocates. As with a native stack, a reference into a frame is
+ * valid only while that call is live.
+ */
+pub fn run(
+    functions: &[CodeFunction],
+    num_global_variables: usize,
+    function_index: usize,
+    arguments: Vec<Value>,
+    heap: &mut Heap,
+) -> Value {
+    let mut globals = value::Frame::new(num_global_variables);
+    let mut stack: Vec<Value> = Vec::new();
+    let mut frames: Vec<Frame> = Vec::new();
+
+    let mut locals = value::Frame::new(functions[function_index].num_local_variables);
+    for (index, argument) in arguments.into_iter().enumerate() {
+        locals.set(index, argument);
+    }
+    let mut frame = Frame {
+        function_index,
+        counter: 0,
+        locals,
+        stack_base: 0,
+    };
+
+    loop {
+        let instruction = &functions[frame.function_index].instructions[frame.counter];
+        frame.counter += 1;
+        match *instruction {
+            Instruction::PushInteger(value) => stack.push(Value::from_integer(value)),
+            Instruction::PushFloat(value) => stack.push(Value::from_float(value)),
+            Instruction::PushGlobalRef(index) => {
+                stack.push(Value::from_reference(globals.slot_ptr(index)))
+            }
+            Instruction::PushLocalRef(index) => {
+                stack.push(Value::from_reference(frame.locals.slot_ptr(index)))
+            }
+            Instruction::Deref => {
+                let reference = stack.pop().expect("Deref on an empty stack");
+                assert!(reference.is_reference(), "Deref on a non-reference");
+                stack.push(unsafe { *reference.to_reference() });
+            }
+            Instruction::IAdd => {
+                let right = stack.pop().expect("IAdd on an empty stack");
+                let left = stack.pop().expect("IAdd on an empty stack");
+                assert!(
+                    left.is_integer() && right.is_integer(),
+                    "IAdd on a non-integer"
+                );
+                // The sum wraps in the 48-bit payload.
+                let sum = left.to_integer().wrapping_add(right.to_integer());
+                stack.push(Value::from_integer((sum << 16) >> 16));
+            }
+            Instruction::Field { offset, size } => {
+                let structure = stack.pop().expect("Field on an empty stack");
+                stack.push(read_field(structure, offset, size, heap));
+            }
+            Instruction::FieldRef { offset, size: _ } => {
+                let reference = stack.pop().expect("FieldRef on an empty stack");
+                assert!(reference.is_reference(), "FieldRef on a non-reference");
+                let structure = unsafe { *reference.to_reference() };
+                assert!(structure.is_reference(), "FieldRef on a non-structure");
+                stack.push(Value::from_reference(unsafe {
+                    structure.to_reference().add(offset)
+                }));
+            }
+            Instruction::FieldOfLocal {
+                index,
+                offset,
+                size,
+            } => {
+                let structure = frame.locals.get(index);
+                stack.push(read_field(structure, offset, size, heap));
+            }
+            Instruction::Call {
+                function_index,
+                num_arguments,
+            } => {
+                let mut locals = value::Frame::new(functions[function_index].num_local_variables);
+                let arguments_start = stack.len() - num_arguments;
+                for (index, argument) in stack.drain(arguments_start..).enumerate() {
+                    locals.set(index, argument);
+                }
+                let stack_base = stack.len();
+                frames.push(std::mem::replace(
+                    &mut frame,
+                    Frame {
+                        function_index,
+                        counter: 0,
+                        locals,
+                        stack_base,
+                    },
+                ));
+            }
+            Instruction::StoreLocal(index) => {
+                let value = stack.pop().expect("StoreLocal on an empty stack");
+                frame.locals.set(index, value);
+            }
+            Instruction::Store => {
+                let value = stack.pop().expect("Store on an empty stack");
+                let reference = stack.pop().expect("Store on an empty stack");
+                assert!(reference.is_reference(), "Store on a non-reference");
+                unsafe { *reference.to_reference() = value };
+                stack.push(value);
+            }
+            Instruction::Drop => {
+                stack.pop();
+            }
+            Instruction::Jump(target) => frame.counter = target,
+            Instruction::JumpIfZero(target) => {
+                let condition = stack.pop().expect("JumpIfZero on an empty stack");
+                assert!(condition.is_integer(), "JumpIfZero on a non-integer");
+                if condition.to_integer() == 0 {
+                    frame.counter = target;
+                }
+            }
+            Instruction::Return => {
+                // The body leaves its return value, if any, as the only
+                // operand above the frame's base; a body ending in a
+                // non-expression statement returns the empty tuple: a
+                // reference to an empty cell.
+                let return_value = if stack.len() > frame.stack_base {
+                    stack.pop().unwrap()
+                } else {
+                    heap.alloc(Vec::new())
+                };
+                stack.truncate(frame.stack_base);
+                match frames.pop() {
+                    Some(parent) => {
+                        frame = parent;
+                        stack.push(return_value);
+                    }
+                    None => return return_value,
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Reads the `size` words starting at word `offset` of the cell behind
+ * `structure`: the word itself when `size` is one, a copy in a fresh cell
+ * of `heap` otherwise.
+ */
+fn read_field(structure: Value, offset: usize, size: usize, heap: &mut Heap) -> Value {
+    assert!(structure.is_reference(), "field access on a non-structure");
+    let cell = structure.to_reference();
+    if size == 1 {
+        unsafe { *cell.add(offset) }
+    } else {
+        heap.alloc(
+            (0..size)
+                .map(|word| unsafe { *cell.add(offset + word) })
+                .collect(),
+        )
+    }
+}
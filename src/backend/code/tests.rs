@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#![cfg(test)]
+
+use super::*;
+
+/**
+ * A shorthand to build a resolved call of `function` with the given
+ * arguments.
+ */
+fn call(function: Function, arguments: Vec<Expression>) -> Expression {
+    Expression::Function {
+        candidates: vec![function],
+        calls: vec![Call { arguments }],
+    }
+}
+
+#[test]
+fn lower_integer_addition() {
+    let definition = FunctionDefinition {
+        num_local_variables: 0,
+        body: vec![Statement::Expr(call(
+            Function::IAdd,
+            vec![Expression::Integer(1), Expression::Integer(2)],
+        ))],
+    };
+    let code = lower_function(&definition, &[]).unwrap();
+    // The trailing expression statement keeps its value as the return
+    // value, so no `Drop` follows the sum.
+    assert_eq!(
+        code.instructions,
+        vec![
+            Instruction::PushInteger(1),
+            Instruction::PushInteger(2),
+            Instruction::IAdd,
+            Instruction::Return,
+        ]
+    );
+}
+
+#[test]
+fn reject_unresolved_call() {
+    // Resolution left two candidates, which bytecode cannot encode.
+    let definition = FunctionDefinition {
+        num_local_variables: 0,
+        body: vec![Statement::Expr(Expression::Function {
+            candidates: vec![Function::IAdd, Function::UserDefined(0)],
+            calls: vec![Call {
+                arguments: vec![Expression::Integer(1), Expression::Integer(2)],
+            }],
+        })],
+    };
+    assert!(matches!(
+        lower_function(&definition, &[]),
+        Err(LowerError::UnresolvedCall)
+    ));
+}
+
+#[test]
+fn run_integer_addition() {
+    // func add(x: int, y: int): int
+    //     x + y
+    // end
+    let definition = FunctionDefinition {
+        num_local_variables: 2,
+        body: vec![Statement::Expr(call(
+            Function::IAdd,
+            vec![
+                call(Function::Deref, vec![Expression::LocalVariable(0)]),
+                call(Function::Deref, vec![Expression::LocalVariable(1)]),
+            ],
+        ))],
+    };
+    let code = lower_function(&definition, &[]).unwrap();
+    let mut heap = Heap::new();
+    let result = run(
+        &[code],
+        0,
+        0,
+        vec![Value::from_integer(40), Value::from_integer(2)],
+        &mut heap,
+    );
+    assert_eq!(result, Value::from_integer(42));
+}
+
+#[test]
+fn run_field_access() {
+    // Reads field 1 of a structure argument whose layout is two fields of
+    // sizes 1 and 2: the access becomes a constant offset of 1, and since
+    // the local never escapes, the tuple is read in place.
+    let definition = FunctionDefinition {
+        num_local_variables: 1,
+        body: vec![Statement::Expr(call(
+            Function::Field {
+                structure_index: 0,
+                field_index: 1,
+            },
+            vec![call(Function::Deref, vec![Expression::LocalVariable(0)])],
+        ))],
+    };
+    let layouts = [Some(Layout {
+        field_offsets: vec![0, 1],
+        field_sizes: vec![1, 2],
+        size: 3,
+    })];
+    let code = lower_function(&definition, &layouts).unwrap();
+    assert_eq!(
+        code.instructions[0],
+        Instruction::FieldOfLocal {
+            index: 0,
+            offset: 1,
+            size: 2,
+        }
+    );
+    let mut heap = Heap::new();
+    let argument = heap.alloc(vec![
+        Value::from_integer(1),
+        Value::from_integer(2),
+        Value::from_integer(3),
+    ]);
+    let result = run(&[code], 0, 0, vec![argument], &mut heap);
+    // The two-word field comes back as a reference to a fresh cell.
+    assert!(result.is_reference());
+    let words = result.to_reference();
+    assert_eq!(unsafe { *words }, Value::from_integer(2));
+    assert_eq!(unsafe { *words.add(1) }, Value::from_integer(3));
+}
+
+#[test]
+fn keep_field_on_escaping_local() {
+    // Local 0 is also handed to a user-defined call, so the field read
+    // stays on the general reference path.
+    let definition = FunctionDefinition {
+        num_local_variables: 1,
+        body: vec![
+            Statement::Expr(call(
+                Function::UserDefined(0),
+                vec![Expression::LocalVariable(0)],
+            )),
+            Statement::Expr(call(
+                Function::Field {
+                    structure_index: 0,
+                    field_index: 0,
+                },
+                vec![call(Function::Deref, vec![Expression::LocalVariable(0)])],
+            )),
+        ],
+    };
+    let code = lower_function(&definition, &[]).unwrap();
+    assert!(code
+        .instructions
+        .contains(&Instruction::Field { offset: 0, size: 1 }));
+    assert!(!code
+        .instructions
+        .iter()
+        .any(|instruction| matches!(instruction, Instruction::FieldOfLocal { .. })));
+}
+
+#[test]
+fn run_global_assignment() {
+    // Stores 7 into global 0, then reads it back; the assignment's own
+    // result is dropped like any other statement result.
+    let definition = FunctionDefinition {
+        num_local_variables: 0,
+        body: vec![
+            Statement::Expr(call(
+                Function::Assign,
+                vec![Expression::GlobalVariable(0), Expression::Integer(7)],
+            )),
+            Statement::Expr(call(Function::Deref, vec![Expression::GlobalVariable(0)])),
+        ],
+    };
+    let code = lower_function(&definition, &[]).unwrap();
+    assert!(code.instructions.contains(&Instruction::Store));
+    let mut heap = Heap::new();
+    let result = run(&[code], 1, 0, vec![], &mut heap);
+    assert_eq!(result, Value::from_integer(7));
+}
+
+#[test]
+fn run_field_ref() {
+    // Copies the structure argument into global 0, then reads field 1
+    // through a reference chain: the field reference derives from the
+    // global's cell without copying the structure.
+    let definition = FunctionDefinition {
+        num_local_variables: 1,
+        body: vec![
+            Statement::Expr(call(
+                Function::Assign,
+                vec![
+                    Expression::GlobalVariable(0),
+                    call(Function::Deref, vec![Expression::LocalVariable(0)]),
+                ],
+            )),
+            Statement::Expr(call(
+                Function::Deref,
+                vec![call(
+                    Function::FieldRef {
+                        structure_index: 0,
+                        field_index: 1,
+                    },
+                    vec![Expression::GlobalVariable(0)],
+                )],
+            )),
+        ],
+    };
+    let layouts = [Some(Layout {
+        field_offsets: vec![0, 1],
+        field_sizes: vec![1, 1],
+        size: 2,
+    })];
+    let code = lower_function(&definition, &layouts).unwrap();
+    let mut heap = Heap::new();
+    let argument = heap.alloc(vec![Value::from_integer(10), Value::from_integer(20)]);
+    let result = run(&[code], 1, 0, vec![argument], &mut heap);
+    assert_eq!(result, Value::from_integer(20));
+}
+
+#[test]
+fn run_call_in_expression() {
+    // 1 + f(40) where f(x) = x + 1: the callee must not take the operand
+    // the caller already left pending on the stack.
+    let caller = FunctionDefinition {
+        num_local_variables: 0,
+        body: vec![Statement::Expr(call(
+            Function::IAdd,
+            vec![
+                Expression::Integer(1),
+                call(Function::UserDefined(1), vec![Expression::Integer(40)]),
+            ],
+        ))],
+    };
+    let callee = FunctionDefinition {
+        num_local_variables: 1,
+        body: vec![Statement::Expr(call(
+            Function::IAdd,
+            vec![
+                call(Function::Deref, vec![Expression::LocalVariable(0)]),
+                Expression::Integer(1),
+            ],
+        ))],
+    };
+    let functions = [
+        lower_function(&caller, &[]).unwrap(),
+        lower_function(&callee, &[]).unwrap(),
+    ];
+    let mut heap = Heap::new();
+    let result = run(&functions, 0, 0, vec![], &mut heap);
+    assert_eq!(result, Value::from_integer(42));
+}
+
+#[test]
+fn run_while_loop() {
+    // Counts from 0 up by checking the loop condition only: the condition
+    // dereferences local 0, which stays 0, so the body never runs.
+    let definition = FunctionDefinition {
+        num_local_variables: 1,
+        body: vec![Statement::While(
+            call(Function::Deref, vec![Expression::LocalVariable(0)]),
+            vec![Statement::Expr(Expression::Integer(1))],
+        )],
+    };
+    let code = lower_function(&definition, &[]).unwrap();
+    let mut heap = Heap::new();
+    let result = run(&[code], 0, 0, vec![Value::from_integer(0)], &mut heap);
+    // The dropped statement results leave the empty tuple as the result.
+    assert!(result.is_reference());
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * Escape analysis of local variable slots.
+ *
+ * An [`Expression::LocalVariable`] denotes a reference to a frame slot. The
+ * slot escapes when that reference can outlive the expression that created
+ * it: assignments in source are overloaded function calls taking
+ * references, so a reference that reaches a user-defined call — directly,
+ * through a [`Function::FieldRef`] chain, or by being stored into another
+ * slot with [`Statement::Let`] — may be written to a global or kept alive
+ * arbitrarily long. A slot whose references are all consumed on the spot by
+ * pure builtins such as [`Function::Deref`] and [`Function::Field`] never
+ * escapes, so its value can live in the frame and be read in place: short-
+ * lived tuples in inner loops need no heap cell of their own. The analysis
+ * is consumed by [`code`](super::code) lowering, which keeps escaping slots
+ * on the general reference path.
+ */
+
+use super::{Expression, Function, FunctionDefinition, Statement};
+
+/**
+ * Which local variables of `definition` escape, indexed by slot. A slot is
+ * marked when a reference to it reaches a user-defined call, an unresolved
+ * overload set, or the right side of a [`Statement::Let`]; everything else
+ * provably dies within its expression.
+ */
+pub fn escaping_locals(definition: &FunctionDefinition) -> Vec<bool> {
+    let mut escaping = vec![false; definition.num_local_variables];
+    for statement in &definition.body {
+        collect_statement(statement, &mut escaping);
+    }
+    escaping
+}
+
+fn collect_statement(statement: &Statement, escaping: &mut [bool]) {
+    match statement {
+        Statement::Empty => {}
+        Statement::Expr(expression) => collect_expression(expression, false, escaping),
+        Statement::While(condition, body) => {
+            collect_expression(condition, false, escaping);
+            for statement in body {
+                collect_statement(statement, escaping);
+            }
+        }
+        // A reference produced on the right side is stored into a slot and
+        // can be loaded back later, so its base escapes.
+        Statement::Let(_, expression) => collect_expression(expression, true, escaping),
+    }
+}
+
+/**
+ * Marks the locals whose references can leave `expression`. `escapes` is
+ * whether the result of `expression` itself ends up somewhere with an
+ * unknown lifetime, which matters for the bare references and the
+ * [`Function::FieldRef`] chains that forward their base.
+ */
+fn collect_expression(expression: &Expression, escapes: bool, escaping: &mut [bool]) {
+    match *expression {
+        Expression::Integer(_) | Expression::Float(_) | Expression::GlobalVariable(_) => {}
+        Expression::LocalVariable(index) => {
+            if escapes {
+                escaping[index] = true;
+            }
+        }
+        Expression::Function {
+            ref candidates,
+            ref calls,
+        } => {
+            let arguments_escape = match (candidates.as_slice(), calls.as_slice()) {
+                // Pure builtins consume their reference within the
+                // instruction that executes them.
+                ([Function::Deref | Function::Field { .. } | Function::IAdd], [_]) => false,
+                // A field reference outlives exactly as long as the derived
+                // reference does.
+                ([Function::FieldRef { .. }], [_]) => escapes,
+                _ => true,
+            };
+            for call in calls {
+                for argument in &call.arguments {
+                    collect_expression(argument, arguments_escape, escaping);
+                }
+            }
+        }
+    }
+}
+
+mod tests;
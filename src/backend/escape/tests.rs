@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#![cfg(test)]
+
+use super::*;
+use crate::backend::Call;
+
+/**
+ * A shorthand to build a resolved call of `function` with the given
+ * arguments.
+ */
+fn call(function: Function, arguments: Vec<Expression>) -> Expression {
+    Expression::Function {
+        candidates: vec![function],
+        calls: vec![Call { arguments }],
+    }
+}
+
+#[test]
+fn deref_does_not_escape() {
+    let definition = FunctionDefinition {
+        num_local_variables: 1,
+        body: vec![Statement::Expr(call(
+            Function::Deref,
+            vec![Expression::LocalVariable(0)],
+        ))],
+    };
+    assert_eq!(escaping_locals(&definition), vec![false]);
+}
+
+#[test]
+fn call_argument_escapes() {
+    // An assignment is a user-defined call taking a reference, so the slot
+    // it writes must be reachable after the call returns.
+    let definition = FunctionDefinition {
+        num_local_variables: 2,
+        body: vec![Statement::Expr(call(
+            Function::UserDefined(0),
+            vec![
+                Expression::LocalVariable(0),
+                call(Function::Deref, vec![Expression::LocalVariable(1)]),
+            ],
+        ))],
+    };
+    assert_eq!(escaping_locals(&definition), vec![true, false]);
+}
+
+#[test]
+fn field_ref_forwards_its_base() {
+    // `FieldRef(local)` as a call argument hands out a reference into the
+    // slot, but the same chain consumed by `Deref` dies on the spot.
+    let field_ref = |index| {
+        call(
+            Function::FieldRef {
+                structure_index: 0,
+                field_index: 0,
+            },
+            vec![Expression::LocalVariable(index)],
+        )
+    };
+    let definition = FunctionDefinition {
+        num_local_variables: 2,
+        body: vec![
+            Statement::Expr(call(Function::UserDefined(0), vec![field_ref(0)])),
+            Statement::Expr(call(Function::Deref, vec![field_ref(1)])),
+        ],
+    };
+    assert_eq!(escaping_locals(&definition), vec![true, false]);
+}
+
+#[test]
+fn unresolved_overloads_escape_conservatively() {
+    let definition = FunctionDefinition {
+        num_local_variables: 1,
+        body: vec![Statement::Expr(Expression::Function {
+            candidates: vec![Function::Deref, Function::UserDefined(0)],
+            calls: vec![Call {
+                arguments: vec![Expression::LocalVariable(0)],
+            }],
+        })],
+    };
+    assert_eq!(escaping_locals(&definition), vec![true]);
+}
+
+#[test]
+fn let_of_reference_escapes() {
+    // Storing a bare reference into another slot lets it be loaded back
+    // later, so the base slot escapes.
+    let definition = FunctionDefinition {
+        num_local_variables: 2,
+        body: vec![Statement::Let(1, Expression::LocalVariable(0))],
+    };
+    assert_eq!(escaping_locals(&definition), vec![true, false]);
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * A peephole simplification pass over translated [`Expression`] trees.
+ *
+ * Mechanically generated sources are full of constant subexpressions a
+ * human would not write; folding them right after translation shrinks both
+ * the stored modules and the work left at runtime. A fold only fires when
+ * the candidate set of a call is a single function, since an overloaded
+ * call is not resolved until type checking.
+ */
+
+use super::value::{MAX_INTEGER, MIN_INTEGER};
+use super::{Expression, Function, FunctionDefinition, Statement};
+
+/**
+ * Simplifies every statement of `definition` in place. Called once per
+ * function, right after [`translate_function_definition`]
+ * (../frontend/fn.translate_function_definition.html).
+ */
+pub fn fold_function(definition: &mut FunctionDefinition) {
+    for statement in &mut definition.body {
+        fold_statement(statement);
+    }
+}
+
+fn fold_statement(statement: &mut Statement) {
+    match statement {
+        Statement::Empty => {}
+        Statement::Expr(expression) => fold_expression(expression),
+        Statement::While(condition, body) => {
+            fold_expression(condition);
+            for statement in body {
+                fold_statement(statement);
+            }
+        }
+        Statement::Let(_, expression) => fold_expression(expression),
+    }
+}
+
+/**
+ * Simplifies `expression` bottom-up: arguments first, then the call
+ * itself.
+ *
+ * Two folds are performed. A [`Function::IAdd`] applied to two integer
+ * literals within the runtime's [`MIN_INTEGER`]..=[`MAX_INTEGER`] range
+ * becomes the literal sum, wrapped into that range exactly as the
+ * interpreter wraps it; an out-of-range literal would fail at runtime,
+ * so it is left for the runtime to report. A [`Function::Deref`] of a freshly
+ * created field reference reads the field directly: `Deref(FieldRef(x))`
+ * is `Field(x)`.
+ */
+fn fold_expression(expression: &mut Expression) {
+    let Expression::Function { candidates, calls } = expression else {
+        return;
+    };
+    for call in calls.iter_mut() {
+        for argument in &mut call.arguments {
+            fold_expression(argument);
+        }
+    }
+    let folded = match candidates.as_slice() {
+        [Function::IAdd] => match calls.as_slice() {
+            [call] => match call.arguments.as_slice() {
+                [Expression::Integer(left), Expression::Integer(right)] => {
+                    let range = MIN_INTEGER..=MAX_INTEGER;
+                    if range.contains(left) && range.contains(right) {
+                        // Wrap the sum into the runtime's integer range the
+                        // same way the interpreter does, so folding never
+                        // changes what the program computes.
+                        let sum = (left.wrapping_add(*right) << 16) >> 16;
+                        Some(Expression::Integer(sum))
+                    } else {
+                        None
+                    }
+                }
+                _ => None,
+            },
+            _ => None,
+        },
+        [Function::Deref] => match calls.as_mut_slice() {
+            [call] => match call.arguments.as_mut_slice() {
+                [Expression::Function {
+                    candidates: argument_candidates,
+                    calls: argument_calls,
+                }] => match argument_candidates.as_slice() {
+                    [Function::FieldRef {
+                        structure_index,
+                        field_index,
+                    }] => Some(Expression::Function {
+                        candidates: vec![Function::Field {
+                            structure_index: *structure_index,
+                            field_index: *field_index,
+                        }],
+                        calls: std::mem::take(argument_calls),
+                    }),
+                    _ => None,
+                },
+                _ => None,
+            },
+            _ => None,
+        },
+        _ => None,
+    };
+    if let Some(folded) = folded {
+        *expression = folded;
+    }
+}
+
+mod tests;
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#![cfg(test)]
+
+use super::*;
+use crate::backend::Call;
+
+/**
+ * A shorthand to build a resolved call of `function` with the given
+ * arguments.
+ */
+fn call(function: Function, arguments: Vec<Expression>) -> Expression {
+    Expression::Function {
+        candidates: vec![function],
+        calls: vec![Call { arguments }],
+    }
+}
+
+#[test]
+fn fold_integer_addition() {
+    let mut expression = call(
+        Function::IAdd,
+        vec![Expression::Integer(1), Expression::Integer(2)],
+    );
+    fold_expression(&mut expression);
+    assert!(matches!(expression, Expression::Integer(3)));
+}
+
+#[test]
+fn fold_nested_integer_addition() {
+    let mut expression = call(
+        Function::IAdd,
+        vec![
+            call(
+                Function::IAdd,
+                vec![Expression::Integer(1), Expression::Integer(2)],
+            ),
+            Expression::Integer(3),
+        ],
+    );
+    fold_expression(&mut expression);
+    assert!(matches!(expression, Expression::Integer(6)));
+}
+
+#[test]
+fn fold_wrapping_addition() {
+    // The runtime wraps sums into its integer range, so the fold wraps the
+    // same way rather than keeping the call.
+    let mut expression = call(
+        Function::IAdd,
+        vec![Expression::Integer(MAX_INTEGER), Expression::Integer(1)],
+    );
+    fold_expression(&mut expression);
+    let Expression::Integer(folded) = expression else {
+        panic!("Not folded");
+    };
+    assert_eq!(folded, MIN_INTEGER);
+}
+
+#[test]
+fn keep_out_of_range_addition() {
+    // A literal beyond the runtime's integer range fails at runtime; the
+    // fold leaves it alone so the failure stays where the program wrote it.
+    let mut expression = call(
+        Function::IAdd,
+        vec![Expression::Integer(MAX_INTEGER + 1), Expression::Integer(1)],
+    );
+    fold_expression(&mut expression);
+    assert!(matches!(expression, Expression::Function { .. }));
+}
+
+#[test]
+fn keep_overloaded_addition() {
+    let mut expression = Expression::Function {
+        candidates: vec![Function::IAdd, Function::Deref],
+        calls: vec![Call {
+            arguments: vec![Expression::Integer(1), Expression::Integer(2)],
+        }],
+    };
+    fold_expression(&mut expression);
+    assert!(matches!(expression, Expression::Function { .. }));
+}
+
+#[test]
+fn fold_deref_of_field_ref() {
+    let mut expression = call(
+        Function::Deref,
+        vec![call(
+            Function::FieldRef {
+                structure_index: 2,
+                field_index: 1,
+            },
+            vec![Expression::LocalVariable(0)],
+        )],
+    );
+    fold_expression(&mut expression);
+    let Expression::Function { candidates, calls } = expression else {
+        panic!("Not a call");
+    };
+    assert!(matches!(
+        candidates.as_slice(),
+        [Function::Field {
+            structure_index: 2,
+            field_index: 1,
+        }]
+    ));
+    let [call] = calls.as_slice() else {
+        panic!("Not a single call");
+    };
+    assert!(matches!(
+        call.arguments.as_slice(),
+        [Expression::LocalVariable(0)]
+    ));
+}
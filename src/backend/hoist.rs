@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * Loop-invariant code motion over [`Statement::While`] bodies.
+ *
+ * Compute kernels reduce to nested `while` loops that re-derive the same
+ * `Deref`/`Field` chains every iteration. This pass moves such a chain in
+ * front of the loop: the chain is evaluated once into a fresh local by a
+ * [`Statement::Let`], and each occurrence inside the loop becomes a
+ * single dereference of that local. Only chains the loop condition
+ * evaluates are moved — the condition runs before the body can, so the
+ * evaluation in front of the loop is never speculative, even when the
+ * loop runs zero iterations. Occurrences in the body of a chain hoisted
+ * from the condition reuse its local; a chain appearing only in the body
+ * stays where it is.
+ *
+ * A chain is moved only when it is pure — built from literals, variable
+ * references and single-candidate [`Function::Deref`], [`Function::Field`],
+ * [`Function::FieldRef`] and [`Function::IAdd`] calls — and none of the
+ * variables it touches can change while the loop runs. The analysis is
+ * deliberately conservative: a variable counts as changing if its
+ * reference reaches any impure call anywhere in the loop (assignments are
+ * overloaded calls taking a reference), and every global counts as
+ * changing if the loop calls any user-defined function. Inner loops are
+ * processed first, so a chain invariant at several depths migrates all the
+ * way out one level at a time.
+ */
+
+use std::collections::HashSet;
+
+use super::{Call, Definitions, Expression, Function, FunctionDefinition, Statement};
+
+/**
+ * Hoists loop-invariant chains in every function body.
+ */
+pub fn hoist_program(definitions: &mut Definitions) {
+    for definition in &mut definitions.function_definitions {
+        hoist_function(definition);
+    }
+}
+
+/**
+ * Hoists loop-invariant chains in `definition`, appending a fresh local
+ * per hoisted chain.
+ */
+pub fn hoist_function(definition: &mut FunctionDefinition) {
+    hoist_block(&mut definition.body, &mut definition.num_local_variables);
+}
+
+/**
+ * What a loop iteration may overwrite, collected by [`collect_written`].
+ */
+struct Written {
+    locals: HashSet<usize>,
+    globals: HashSet<usize>,
+    /**
+     * Whether the loop calls a user-defined function, which may write any
+     * global without naming it.
+     */
+    all_globals: bool,
+}
+
+fn hoist_block(statements: &mut Vec<Statement>, num_local_variables: &mut usize) {
+    for statement in std::mem::take(statements) {
+        match statement {
+            Statement::While(mut condition, mut body) => {
+                // Inner loops first, so their hoisted chains land in this
+                // body and can migrate further out below.
+                hoist_block(&mut body, num_local_variables);
+                let mut written = Written {
+                    locals: HashSet::new(),
+                    globals: HashSet::new(),
+                    all_globals: false,
+                };
+                collect_written_expression(&condition, false, &mut written);
+                for statement in &body {
+                    collect_written_statement(statement, &mut written);
+                }
+                let mut hoisted = Vec::new();
+                hoist_expression(&mut condition, &written, num_local_variables, &mut hoisted);
+                for statement in &mut body {
+                    rewrite_statement(statement, &hoisted);
+                }
+                statements.extend(hoisted);
+                statements.push(Statement::While(condition, body));
+            }
+            statement => statements.push(statement),
+        }
+    }
+}
+
+fn collect_written_statement(statement: &Statement, written: &mut Written) {
+    match statement {
+        Statement::Empty => {}
+        Statement::Expr(expression) => collect_written_expression(expression, false, written),
+        Statement::While(condition, body) => {
+            collect_written_expression(condition, false, written);
+            for statement in body {
+                collect_written_statement(statement, written);
+            }
+        }
+        Statement::Let(index, expression) => {
+            written.locals.insert(*index);
+            collect_written_expression(expression, false, written);
+        }
+    }
+}
+
+/**
+ * Records the variables `expression` may overwrite. A variable reference
+ * that reaches an impure call — directly or through other calls — may be
+ * written through; `escaping` is whether the surrounding context is such
+ * an argument position.
+ */
+fn collect_written_expression(expression: &Expression, escaping: bool, written: &mut Written) {
+    match expression {
+        Expression::Integer(_) | Expression::Float(_) => {}
+        Expression::GlobalVariable(index) => {
+            if escaping {
+                written.globals.insert(*index);
+            }
+        }
+        Expression::LocalVariable(index) => {
+            if escaping {
+                written.locals.insert(*index);
+            }
+        }
+        Expression::Function { candidates, calls } => {
+            let pure = is_pure(candidates);
+            if !pure && contains_user_defined(candidates) {
+                written.all_globals = true;
+            }
+            for call in calls {
+                for argument in &call.arguments {
+                    collect_written_expression(argument, escaping || !pure, written);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Whether a resolved candidate set consists of one builtin that reads its
+ * arguments without writing through them.
+ */
+fn is_pure(candidates: &[Function]) -> bool {
+    matches!(
+        candidates,
+        [Function::Deref | Function::Field { .. } | Function::FieldRef { .. } | Function::IAdd]
+    )
+}
+
+fn contains_user_defined(candidates: &[Function]) -> bool {
+    candidates
+        .iter()
+        .any(|candidate| matches!(candidate, Function::UserDefined(_)))
+}
+
+/**
+ * Replaces `expression` by a dereference of a hoisted local if the whole
+ * expression is an invariant chain, and otherwise recurses to find
+ * invariant subchains. A chain equal to one already in `hoisted` reuses
+ * its local; only a new chain takes a fresh one.
+ */
+fn hoist_expression(
+    expression: &mut Expression,
+    written: &Written,
+    num_local_variables: &mut usize,
+    hoisted: &mut Vec<Statement>,
+) {
+    if matches!(expression, Expression::Function { .. }) && is_invariant(expression, written) {
+        let index = match hoisted_local(expression, hoisted) {
+            Some(index) => index,
+            None => {
+                let index = *num_local_variables;
+                *num_local_variables += 1;
+                let chain = std::mem::replace(expression, Expression::LocalVariable(index));
+                hoisted.push(Statement::Let(index, chain));
+                index
+            }
+        };
+        *expression = Expression::Function {
+            candidates: vec![Function::Deref],
+            calls: vec![Call {
+                arguments: vec![Expression::LocalVariable(index)],
+            }],
+        };
+        return;
+    }
+    if let Expression::Function { calls, .. } = expression {
+        for call in calls {
+            for argument in &mut call.arguments {
+                hoist_expression(argument, written, num_local_variables, hoisted);
+            }
+        }
+    }
+}
+
+/**
+ * Replaces every occurrence in `statement` of a chain already hoisted
+ * from the loop condition by a dereference of its local.
+ */
+fn rewrite_statement(statement: &mut Statement, hoisted: &[Statement]) {
+    match statement {
+        Statement::Empty => {}
+        Statement::Expr(expression) | Statement::Let(_, expression) => {
+            rewrite_expression(expression, hoisted)
+        }
+        Statement::While(condition, body) => {
+            rewrite_expression(condition, hoisted);
+            for statement in body {
+                rewrite_statement(statement, hoisted);
+            }
+        }
+    }
+}
+
+fn rewrite_expression(expression: &mut Expression, hoisted: &[Statement]) {
+    if let Some(index) = hoisted_local(expression, hoisted) {
+        *expression = Expression::Function {
+            candidates: vec![Function::Deref],
+            calls: vec![Call {
+                arguments: vec![Expression::LocalVariable(index)],
+            }],
+        };
+        return;
+    }
+    if let Expression::Function { calls, .. } = expression {
+        for call in calls {
+            for argument in &mut call.arguments {
+                rewrite_expression(argument, hoisted);
+            }
+        }
+    }
+}
+
+/**
+ * The local a chain equal to `expression` was already hoisted into, if
+ * any.
+ */
+fn hoisted_local(expression: &Expression, hoisted: &[Statement]) -> Option<usize> {
+    hoisted.iter().find_map(|statement| match statement {
+        Statement::Let(index, chain) if same_expression(chain, expression) => Some(*index),
+        _ => None,
+    })
+}
+
+/**
+ * Structural equality over expressions, used to recognize occurrences of
+ * a hoisted chain. Float literals compare by IEEE equality, so a chain
+ * containing a NaN literal is never recognized — conservative, since an
+ * occurrence left in place stays correct.
+ */
+fn same_expression(left: &Expression, right: &Expression) -> bool {
+    match (left, right) {
+        (Expression::Integer(left), Expression::Integer(right)) => left == right,
+        (Expression::Float(left), Expression::Float(right)) => left == right,
+        (Expression::GlobalVariable(left), Expression::GlobalVariable(right)) => left == right,
+        (Expression::LocalVariable(left), Expression::LocalVariable(right)) => left == right,
+        (
+            Expression::Function {
+                candidates: left_candidates,
+                calls: left_calls,
+            },
+            Expression::Function {
+                candidates: right_candidates,
+                calls: right_calls,
+            },
+        ) => {
+            left_candidates == right_candidates
+                && left_calls.len() == right_calls.len()
+                && left_calls.iter().zip(right_calls).all(|(left, right)| {
+                    left.arguments.len() == right.arguments.len()
+                        && left
+                            .arguments
+                            .iter()
+                            .zip(&right.arguments)
+                            .all(|(left, right)| same_expression(left, right))
+                })
+        }
+        _ => false,
+    }
+}
+
+/**
+ * Whether evaluating `expression` yields the same value on every iteration
+ * of the loop whose writes are `written`.
+ */
+fn is_invariant(expression: &Expression, written: &Written) -> bool {
+    match expression {
+        Expression::Integer(_) | Expression::Float(_) => true,
+        Expression::GlobalVariable(index) => {
+            !written.all_globals && !written.globals.contains(index)
+        }
+        Expression::LocalVariable(index) => !written.locals.contains(index),
+        Expression::Function { candidates, calls } => {
+            is_pure(candidates)
+                && calls
+                    .iter()
+                    .flat_map(|call| &call.arguments)
+                    .all(|argument| is_invariant(argument, written))
+        }
+    }
+}
+
+mod tests;
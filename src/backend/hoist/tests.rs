@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#![cfg(test)]
+
+use super::*;
+
+/**
+ * A shorthand to build a resolved call of `function` with the given
+ * arguments.
+ */
+fn call(function: Function, arguments: Vec<Expression>) -> Expression {
+    Expression::Function {
+        candidates: vec![function],
+        calls: vec![Call { arguments }],
+    }
+}
+
+/**
+ * A field read of the local with index `index`: `Field(Deref(local))`.
+ */
+fn field_chain(index: usize) -> Expression {
+    call(
+        Function::Field {
+            structure_index: 0,
+            field_index: 0,
+        },
+        vec![call(
+            Function::Deref,
+            vec![Expression::LocalVariable(index)],
+        )],
+    )
+}
+
+/**
+ * Whether `expression` is a dereference of the local with index `index`.
+ */
+fn is_deref_of_local(expression: &Expression, index: usize) -> bool {
+    let Expression::Function { candidates, calls } = expression else {
+        return false;
+    };
+    matches!(candidates.as_slice(), [Function::Deref])
+        && matches!(
+            calls.as_slice(),
+            [Call { arguments }]
+                if matches!(arguments.as_slice(), [Expression::LocalVariable(i)] if *i == index)
+        )
+}
+
+#[test]
+fn hoist_condition_chain_on_untouched_local() {
+    let mut definition = FunctionDefinition {
+        num_local_variables: 2,
+        body: vec![Statement::While(
+            // Reads a field of local 1, which nothing writes.
+            field_chain(1),
+            // Writes local 0 through a user-defined call.
+            vec![Statement::Expr(call(
+                Function::UserDefined(0),
+                vec![Expression::LocalVariable(0)],
+            ))],
+        )],
+    };
+    hoist_function(&mut definition);
+    assert_eq!(definition.num_local_variables, 3);
+    let [Statement::Let(2, chain), Statement::While(condition, _)] = definition.body.as_slice()
+    else {
+        panic!("expected a hoisted let before the loop");
+    };
+    assert!(matches!(chain, Expression::Function { .. }));
+    assert!(is_deref_of_local(condition, 2));
+}
+
+#[test]
+fn body_occurrence_reuses_hoisted_local() {
+    // The same chain appears in the condition and in the body; both become
+    // dereferences of a single hoisted local.
+    let mut definition = FunctionDefinition {
+        num_local_variables: 2,
+        body: vec![Statement::While(
+            field_chain(1),
+            vec![Statement::Expr(field_chain(1))],
+        )],
+    };
+    hoist_function(&mut definition);
+    assert_eq!(definition.num_local_variables, 3);
+    let [Statement::Let(2, _), Statement::While(condition, body)] = definition.body.as_slice()
+    else {
+        panic!("expected a single hoisted let before the loop");
+    };
+    assert!(is_deref_of_local(condition, 2));
+    let [Statement::Expr(replacement)] = body.as_slice() else {
+        panic!("expected a single statement in the body");
+    };
+    assert!(is_deref_of_local(replacement, 2));
+}
+
+#[test]
+fn keep_body_only_chain() {
+    // The chain never reaches the condition, so the body may run zero
+    // times without evaluating it; moving it in front of the loop would
+    // evaluate it speculatively.
+    let mut definition = FunctionDefinition {
+        num_local_variables: 1,
+        body: vec![Statement::While(
+            Expression::Integer(1),
+            vec![Statement::Expr(field_chain(0))],
+        )],
+    };
+    hoist_function(&mut definition);
+    assert_eq!(definition.num_local_variables, 1);
+    let [Statement::While(_, body)] = definition.body.as_slice() else {
+        panic!("expected the loop to stay first");
+    };
+    assert!(matches!(
+        body.as_slice(),
+        [Statement::Expr(Expression::Function { .. })]
+    ));
+}
+
+#[test]
+fn keep_chain_on_written_local() {
+    let mut definition = FunctionDefinition {
+        num_local_variables: 1,
+        body: vec![Statement::While(
+            field_chain(0),
+            vec![Statement::Expr(call(
+                Function::UserDefined(0),
+                vec![Expression::LocalVariable(0)],
+            ))],
+        )],
+    };
+    hoist_function(&mut definition);
+    assert_eq!(definition.num_local_variables, 1);
+    assert!(matches!(
+        definition.body.as_slice(),
+        [Statement::While(Expression::Function { .. }, _)]
+    ));
+}
+
+#[test]
+fn keep_global_read_when_loop_calls_functions() {
+    let mut definition = FunctionDefinition {
+        num_local_variables: 0,
+        body: vec![Statement::While(
+            call(Function::Deref, vec![Expression::GlobalVariable(0)]),
+            // Any user-defined call may write any global.
+            vec![Statement::Expr(call(Function::UserDefined(0), vec![]))],
+        )],
+    };
+    hoist_function(&mut definition);
+    assert_eq!(definition.num_local_variables, 0);
+    assert!(matches!(definition.body.as_slice(), [Statement::While(..)]));
+}
+
+#[test]
+fn hoist_global_read_without_calls() {
+    let mut definition = FunctionDefinition {
+        num_local_variables: 0,
+        body: vec![Statement::While(
+            call(Function::Deref, vec![Expression::GlobalVariable(0)]),
+            vec![Statement::Empty],
+        )],
+    };
+    hoist_function(&mut definition);
+    assert_eq!(definition.num_local_variables, 1);
+    assert!(matches!(
+        definition.body.as_slice(),
+        [Statement::Let(0, _), Statement::While(..)]
+    ));
+}
+
+#[test]
+fn chain_migrates_out_of_nested_loops() {
+    let mut definition = FunctionDefinition {
+        num_local_variables: 1,
+        body: vec![Statement::While(
+            field_chain(0),
+            vec![Statement::While(
+                field_chain(0),
+                vec![Statement::Expr(field_chain(0))],
+            )],
+        )],
+    };
+    hoist_function(&mut definition);
+    // The inner condition's chain is hoisted into the outer body first;
+    // the outer pass then hoists the same chain from its own condition and
+    // rewrites the inner let to reuse the outer local.
+    assert_eq!(definition.num_local_variables, 3);
+    let [Statement::Let(2, chain), Statement::While(outer_condition, outer_body)] =
+        definition.body.as_slice()
+    else {
+        panic!("expected the chain in front of the outer loop");
+    };
+    assert!(matches!(chain, Expression::Function { .. }));
+    assert!(is_deref_of_local(outer_condition, 2));
+    let [Statement::Let(1, forwarded), Statement::While(inner_condition, inner_body)] =
+        outer_body.as_slice()
+    else {
+        panic!("expected the inner let to remain in the outer body");
+    };
+    assert!(is_deref_of_local(forwarded, 2));
+    assert!(is_deref_of_local(inner_condition, 1));
+    let [Statement::Expr(replacement)] = inner_body.as_slice() else {
+        panic!("expected a single statement in the inner body");
+    };
+    assert!(is_deref_of_local(replacement, 1));
+}
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * Inline expansion of small user-defined functions.
+ *
+ * Accessor-heavy sources wrap field reads and one-operator arithmetic in
+ * tiny functions, so most calls dispatch into a body smaller than the call
+ * itself. This pass substitutes such bodies at the call site: a call
+ * through a single [`Function::UserDefined`] candidate is replaced by the
+ * callee's expression when the callee body is a single
+ * [`Statement::Expr`] below [`MAX_INLINE_SIZE`] nodes and every argument
+ * is an atom (a literal or a reference), so duplicating or dropping an
+ * argument cannot change what the program computes. A call copies each
+ * argument value into the callee's parameter slot, and the callee reads
+ * it back as a [`Function::Deref`] of the slot, so substitution replaces
+ * that read with the argument expression itself; a body that takes a
+ * reference to the slot — a bare [`Expression::LocalVariable`] below the
+ * arity — has no counterpart in the caller's frame and keeps its call.
+ * Callee locals beyond the parameters are remapped to fresh slots in the
+ * caller.
+ *
+ * The pass runs once over the whole program, after every file is
+ * translated, so callees from other files and from later in the same file
+ * are available. It does not iterate to a fixpoint, and a function is
+ * never inlined into itself, so recursive accessors cannot make it grow
+ * without bound.
+ */
+
+use super::{Call, Definitions, Expression, Function, FunctionDefinition, FunctionTy, Statement};
+
+/**
+ * The largest callee body, in expression nodes, that is worth substituting
+ * for a call.
+ */
+const MAX_INLINE_SIZE: usize = 16;
+
+/**
+ * Inlines eligible calls in every function body and in no particular
+ * order; each call site sees the callee bodies as translation produced
+ * them, not as this pass rewrites them.
+ */
+pub fn inline_program(definitions: &mut Definitions) {
+    for index in 0..definitions.function_definitions.len() {
+        let mut definition = std::mem::replace(
+            &mut definitions.function_definitions[index],
+            FunctionDefinition {
+                num_local_variables: 0,
+                body: Vec::new(),
+            },
+        );
+        for statement in &mut definition.body {
+            inline_statement(
+                statement,
+                index,
+                &definitions.function_tys,
+                &definitions.function_definitions,
+                &mut definition.num_local_variables,
+            );
+        }
+        definitions.function_definitions[index] = definition;
+    }
+}
+
+fn inline_statement(
+    statement: &mut Statement,
+    caller_index: usize,
+    function_tys: &[FunctionTy],
+    functions: &[FunctionDefinition],
+    num_local_variables: &mut usize,
+) {
+    match statement {
+        Statement::Empty => {}
+        Statement::Expr(expression) => inline_expression(
+            expression,
+            caller_index,
+            function_tys,
+            functions,
+            num_local_variables,
+        ),
+        Statement::While(condition, body) => {
+            inline_expression(
+                condition,
+                caller_index,
+                function_tys,
+                functions,
+                num_local_variables,
+            );
+            for statement in body {
+                inline_statement(
+                    statement,
+                    caller_index,
+                    function_tys,
+                    functions,
+                    num_local_variables,
+                );
+            }
+        }
+        Statement::Let(_, expression) => inline_expression(
+            expression,
+            caller_index,
+            function_tys,
+            functions,
+            num_local_variables,
+        ),
+    }
+}
+
+/**
+ * Inlines `expression` bottom-up: arguments first, so that an accessor
+ * call feeding another accessor call is expanded innermost-first and the
+ * outer call then sees an atom where possible.
+ */
+fn inline_expression(
+    expression: &mut Expression,
+    caller_index: usize,
+    function_tys: &[FunctionTy],
+    functions: &[FunctionDefinition],
+    num_local_variables: &mut usize,
+) {
+    let Expression::Function { candidates, calls } = expression else {
+        return;
+    };
+    for call in calls.iter_mut() {
+        for argument in &mut call.arguments {
+            inline_expression(
+                argument,
+                caller_index,
+                function_tys,
+                functions,
+                num_local_variables,
+            );
+        }
+    }
+    let &[Function::UserDefined(callee_index)] = candidates.as_slice() else {
+        return;
+    };
+    if callee_index == caller_index {
+        return;
+    }
+    let [call] = calls.as_slice() else {
+        return;
+    };
+    let callee = &functions[callee_index];
+    let arity = function_tys[callee_index].parameters_ty.len();
+    if call.arguments.len() != arity {
+        return;
+    }
+    let [Statement::Expr(body)] = callee.body.as_slice() else {
+        return;
+    };
+    if expression_size(body) > MAX_INLINE_SIZE {
+        return;
+    }
+    if !call.arguments.iter().all(is_atom) {
+        return;
+    }
+    // Callee locals beyond the parameters get fresh slots in the caller.
+    let local_base = *num_local_variables;
+    let Some(inlined) = substitute(body, &call.arguments, arity, local_base) else {
+        return;
+    };
+    *num_local_variables += callee.num_local_variables.saturating_sub(arity);
+    *expression = inlined;
+}
+
+/**
+ * Whether duplicating or dropping `expression` is free of side effects and
+ * of cost: literals and bare variable reads are, calls are not.
+ */
+fn is_atom(expression: &Expression) -> bool {
+    match expression {
+        Expression::Integer(_)
+        | Expression::Float(_)
+        | Expression::GlobalVariable(_)
+        | Expression::LocalVariable(_) => true,
+        Expression::Function { .. } => false,
+    }
+}
+
+/**
+ * The number of expression nodes in `expression`.
+ */
+fn expression_size(expression: &Expression) -> usize {
+    match expression {
+        Expression::Integer(_)
+        | Expression::Float(_)
+        | Expression::GlobalVariable(_)
+        | Expression::LocalVariable(_) => 1,
+        Expression::Function { calls, .. } => {
+            1 + calls
+                .iter()
+                .flat_map(|call| &call.arguments)
+                .map(expression_size)
+                .sum::<usize>()
+        }
+    }
+}
+
+/**
+ * A copy of the callee expression `body` with parameter reads replaced by
+ * the call's arguments and the remaining locals shifted to start at
+ * `local_base`. A call copies each argument value into the callee's
+ * parameter slot, and a read of the slot — a [`Function::Deref`] of it —
+ * yields that value again, so the read becomes the argument expression
+ * itself. A bare parameter slot is a reference into the callee's own
+ * frame, which no caller expression reproduces; `None` means the body
+ * uses one and the call must stay.
+ */
+fn substitute(
+    body: &Expression,
+    arguments: &[Expression],
+    arity: usize,
+    local_base: usize,
+) -> Option<Expression> {
+    if let Some(index) = deref_of_parameter(body, arity) {
+        return Some(clone_atom(&arguments[index]));
+    }
+    match *body {
+        Expression::Integer(value) => Some(Expression::Integer(value)),
+        Expression::Float(value) => Some(Expression::Float(value)),
+        Expression::GlobalVariable(index) => Some(Expression::GlobalVariable(index)),
+        Expression::LocalVariable(index) => {
+            if index < arity {
+                None
+            } else {
+                Some(Expression::LocalVariable(local_base + index - arity))
+            }
+        }
+        Expression::Function {
+            ref candidates,
+            ref calls,
+        } => {
+            let mut substituted_calls = Vec::with_capacity(calls.len());
+            for call in calls {
+                let mut substituted_arguments = Vec::with_capacity(call.arguments.len());
+                for argument in &call.arguments {
+                    substituted_arguments.push(substitute(argument, arguments, arity, local_base)?);
+                }
+                substituted_calls.push(Call {
+                    arguments: substituted_arguments,
+                });
+            }
+            Some(Expression::Function {
+                candidates: candidates.clone(),
+                calls: substituted_calls,
+            })
+        }
+    }
+}
+
+/**
+ * The parameter index read by `expression`, when `expression` is a
+ * resolved [`Function::Deref`] call of a single parameter slot.
+ */
+fn deref_of_parameter(expression: &Expression, arity: usize) -> Option<usize> {
+    let Expression::Function { candidates, calls } = expression else {
+        return None;
+    };
+    let [Function::Deref] = candidates.as_slice() else {
+        return None;
+    };
+    let [call] = calls.as_slice() else {
+        return None;
+    };
+    let &[Expression::LocalVariable(index)] = call.arguments.as_slice() else {
+        return None;
+    };
+    (index < arity).then_some(index)
+}
+
+/**
+ * A copy of an argument already checked by [`is_atom`].
+ */
+fn clone_atom(argument: &Expression) -> Expression {
+    match *argument {
+        Expression::Integer(value) => Expression::Integer(value),
+        Expression::Float(value) => Expression::Float(value),
+        Expression::GlobalVariable(index) => Expression::GlobalVariable(index),
+        Expression::LocalVariable(index) => Expression::LocalVariable(index),
+        Expression::Function { .. } => unreachable!(),
+    }
+}
+
+mod tests;
@@ -0,0 +1,451 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#![cfg(test)]
+
+use super::*;
+use crate::backend::{code, value, TyBuilder, TyConstructor};
+
+/**
+ * A shorthand to build a resolved call of `function` with the given
+ * arguments.
+ */
+fn call(function: Function, arguments: Vec<Expression>) -> Expression {
+    Expression::Function {
+        candidates: vec![function],
+        calls: vec![Call { arguments }],
+    }
+}
+
+/**
+ * A shorthand for the value read of a variable reference, as translation
+ * emits it.
+ */
+fn deref(reference: Expression) -> Expression {
+    call(Function::Deref, vec![reference])
+}
+
+/**
+ * A shorthand to build a definition taking `arity` integer parameters,
+ * with the given extra locals and single-expression body.
+ */
+fn function(
+    arity: usize,
+    num_extra_locals: usize,
+    body: Expression,
+) -> (FunctionTy, FunctionDefinition) {
+    (
+        FunctionTy {
+            num_ty_parameters: 0,
+            parameters_ty: vec![TyBuilder::Constructor(TyConstructor::Integer); arity],
+            return_ty: TyBuilder::Constructor(TyConstructor::Integer),
+        },
+        FunctionDefinition {
+            num_local_variables: arity + num_extra_locals,
+            body: vec![Statement::Expr(body)],
+        },
+    )
+}
+
+/**
+ * Appends the signature and definition pair built by [`function`] to
+ * `definitions`.
+ */
+fn push(definitions: &mut Definitions, (ty, definition): (FunctionTy, FunctionDefinition)) {
+    definitions.push_function(ty, definition);
+}
+
+#[test]
+fn inline_literal_argument_into_parameter_read() {
+    let mut definitions = Definitions::new();
+    // Function 0: f(x) = x + 1; the parameter read is a dereference of the
+    // parameter slot.
+    push(
+        &mut definitions,
+        function(
+            1,
+            0,
+            call(
+                Function::IAdd,
+                vec![deref(Expression::LocalVariable(0)), Expression::Integer(1)],
+            ),
+        ),
+    );
+    // Function 1: g() = f(5).
+    push(
+        &mut definitions,
+        function(
+            0,
+            0,
+            call(Function::UserDefined(0), vec![Expression::Integer(5)]),
+        ),
+    );
+    inline_program(&mut definitions);
+    // g's body is now 5 + 1 directly.
+    let [Statement::Expr(body)] = definitions.function_definitions[1].body.as_slice() else {
+        panic!("expected a single expression body");
+    };
+    let Expression::Function { candidates, calls } = body else {
+        panic!("expected a call");
+    };
+    assert!(matches!(candidates.as_slice(), [Function::IAdd]));
+    let [Call { arguments }] = calls.as_slice() else {
+        panic!("expected a single call");
+    };
+    assert!(matches!(
+        arguments.as_slice(),
+        [Expression::Integer(5), Expression::Integer(1)]
+    ));
+}
+
+#[test]
+fn inline_reference_argument_into_parameter_read() {
+    let mut definitions = Definitions::new();
+    // Function 0: f(x) = h(x); the parameter read passes the argument value
+    // — here a reference — on to another call.
+    push(
+        &mut definitions,
+        function(
+            1,
+            0,
+            call(
+                Function::UserDefined(1),
+                vec![deref(Expression::LocalVariable(0))],
+            ),
+        ),
+    );
+    // Function 1: h, a one-parameter callee whose body is not inlinable.
+    let (ty, _) = function(1, 0, Expression::Integer(0));
+    definitions.push_function(
+        ty,
+        FunctionDefinition {
+            num_local_variables: 1,
+            body: vec![Statement::Empty],
+        },
+    );
+    // Function 2: g(y) = f(&y), passing a reference to g's own slot.
+    push(
+        &mut definitions,
+        function(
+            1,
+            0,
+            call(Function::UserDefined(0), vec![Expression::LocalVariable(0)]),
+        ),
+    );
+    inline_program(&mut definitions);
+    // The reference value flows to the inner call unchanged.
+    let [Statement::Expr(Expression::Function { candidates, calls })] =
+        definitions.function_definitions[2].body.as_slice()
+    else {
+        panic!("expected a single call body");
+    };
+    assert!(matches!(candidates.as_slice(), [Function::UserDefined(1)]));
+    let [Call { arguments }] = calls.as_slice() else {
+        panic!("expected a single call");
+    };
+    assert!(matches!(
+        arguments.as_slice(),
+        [Expression::LocalVariable(0)]
+    ));
+}
+
+#[test]
+fn keep_call_with_non_atom_argument() {
+    let mut definitions = Definitions::new();
+    // Function 0: f(x) = x + x. Inlining would duplicate the argument.
+    push(
+        &mut definitions,
+        function(
+            1,
+            0,
+            call(
+                Function::IAdd,
+                vec![
+                    deref(Expression::LocalVariable(0)),
+                    deref(Expression::LocalVariable(0)),
+                ],
+            ),
+        ),
+    );
+    // Function 1: g(y) = f(y), with y passed by value — the argument is a
+    // dereference, not an atom.
+    push(
+        &mut definitions,
+        function(
+            1,
+            0,
+            call(
+                Function::UserDefined(0),
+                vec![deref(Expression::LocalVariable(0))],
+            ),
+        ),
+    );
+    inline_program(&mut definitions);
+    let [Statement::Expr(body)] = definitions.function_definitions[1].body.as_slice() else {
+        panic!("expected a single expression body");
+    };
+    let Expression::Function { candidates, .. } = body else {
+        panic!("expected a call");
+    };
+    assert!(matches!(candidates.as_slice(), [Function::UserDefined(0)]));
+}
+
+#[test]
+fn keep_literal_argument_for_reference_use() {
+    let mut definitions = Definitions::new();
+    // Function 0: f(x) takes a reference to its own parameter slot, which
+    // has no counterpart once the frame is gone.
+    push(
+        &mut definitions,
+        function(
+            1,
+            0,
+            call(
+                Function::UserDefined(1),
+                vec![Expression::LocalVariable(0), Expression::Integer(1)],
+            ),
+        ),
+    );
+    // Function 1: a two-parameter callee whose body is not inlinable.
+    let (ty, _) = function(2, 0, Expression::Integer(0));
+    definitions.push_function(
+        ty,
+        FunctionDefinition {
+            num_local_variables: 2,
+            body: vec![Statement::Empty],
+        },
+    );
+    // Function 2: g() = f(5) must stay a call.
+    push(
+        &mut definitions,
+        function(
+            0,
+            0,
+            call(Function::UserDefined(0), vec![Expression::Integer(5)]),
+        ),
+    );
+    inline_program(&mut definitions);
+    let definition = &definitions.function_definitions[2];
+    let [Statement::Expr(Expression::Function { candidates, .. })] = definition.body.as_slice()
+    else {
+        panic!("expected a single call body");
+    };
+    assert!(matches!(candidates.as_slice(), [Function::UserDefined(0)]));
+    // No fresh slots were handed out for the abandoned expansion.
+    assert_eq!(definition.num_local_variables, 0);
+}
+
+#[test]
+fn keep_reference_argument_for_reference_use() {
+    let mut definitions = Definitions::new();
+    // Function 0: f(x) takes a reference to its own parameter slot; even a
+    // reference argument only provides the slot's value, not the slot.
+    push(
+        &mut definitions,
+        function(
+            1,
+            0,
+            call(
+                Function::UserDefined(1),
+                vec![Expression::LocalVariable(0), Expression::Integer(1)],
+            ),
+        ),
+    );
+    // Function 1: a two-parameter callee whose body is not inlinable.
+    let (ty, _) = function(2, 0, Expression::Integer(0));
+    definitions.push_function(
+        ty,
+        FunctionDefinition {
+            num_local_variables: 2,
+            body: vec![Statement::Empty],
+        },
+    );
+    // Function 2: g(y) = f(&y) must stay a call.
+    push(
+        &mut definitions,
+        function(
+            1,
+            0,
+            call(Function::UserDefined(0), vec![Expression::LocalVariable(0)]),
+        ),
+    );
+    inline_program(&mut definitions);
+    let definition = &definitions.function_definitions[2];
+    let [Statement::Expr(Expression::Function { candidates, .. })] = definition.body.as_slice()
+    else {
+        panic!("expected a single call body");
+    };
+    assert!(matches!(candidates.as_slice(), [Function::UserDefined(0)]));
+    // No fresh slots were handed out for the abandoned expansion.
+    assert_eq!(definition.num_local_variables, 1);
+}
+
+#[test]
+fn keep_recursive_call() {
+    let mut definitions = Definitions::new();
+    // Function 0: f(x) = f(x).
+    push(
+        &mut definitions,
+        function(
+            1,
+            0,
+            call(Function::UserDefined(0), vec![Expression::LocalVariable(0)]),
+        ),
+    );
+    inline_program(&mut definitions);
+    let [Statement::Expr(body)] = definitions.function_definitions[0].body.as_slice() else {
+        panic!("expected a single expression body");
+    };
+    let Expression::Function { candidates, .. } = body else {
+        panic!("expected a call");
+    };
+    assert!(matches!(candidates.as_slice(), [Function::UserDefined(0)]));
+}
+
+#[test]
+fn remap_callee_locals_to_fresh_slots() {
+    let mut definitions = Definitions::new();
+    // Function 0: f(x) reads one local of its own beyond the parameter.
+    push(
+        &mut definitions,
+        function(
+            1,
+            1,
+            call(
+                Function::IAdd,
+                vec![
+                    deref(Expression::LocalVariable(0)),
+                    deref(Expression::LocalVariable(1)),
+                ],
+            ),
+        ),
+    );
+    // Function 1: g() = f(7), with two locals of its own.
+    let (ty, mut definition) = function(
+        0,
+        0,
+        call(Function::UserDefined(0), vec![Expression::Integer(7)]),
+    );
+    definition.num_local_variables = 2;
+    push(&mut definitions, (ty, definition));
+    inline_program(&mut definitions);
+    let definition = &definitions.function_definitions[1];
+    // The callee's extra local became caller slot 2.
+    assert_eq!(definition.num_local_variables, 3);
+    let [Statement::Expr(Expression::Function { calls, .. })] = definition.body.as_slice() else {
+        panic!("expected a single call body");
+    };
+    let [Call { arguments }] = calls.as_slice() else {
+        panic!("expected a single call");
+    };
+    let [Expression::Integer(7), read] = arguments.as_slice() else {
+        panic!("expected a literal and a dereference");
+    };
+    let Expression::Function { calls, .. } = read else {
+        panic!("expected a dereference");
+    };
+    assert!(matches!(
+        calls.as_slice(),
+        [Call { arguments }] if matches!(arguments.as_slice(), [Expression::LocalVariable(2)])
+    ));
+}
+
+#[test]
+fn preserve_result_of_inlined_call() {
+    let mut definitions = Definitions::new();
+    // Function 0: f(x) = x + 1.
+    push(
+        &mut definitions,
+        function(
+            1,
+            0,
+            call(
+                Function::IAdd,
+                vec![deref(Expression::LocalVariable(0)), Expression::Integer(1)],
+            ),
+        ),
+    );
+    // Function 1: g() = 1 + f(40).
+    push(
+        &mut definitions,
+        function(
+            0,
+            0,
+            call(
+                Function::IAdd,
+                vec![
+                    Expression::Integer(1),
+                    call(Function::UserDefined(0), vec![Expression::Integer(40)]),
+                ],
+            ),
+        ),
+    );
+    let execute = |definitions: &Definitions| {
+        let functions = code::lower(definitions).unwrap();
+        let mut heap = value::Heap::new();
+        code::run(
+            &functions,
+            definitions.num_global_variables,
+            1,
+            vec![],
+            &mut heap,
+        )
+    };
+    let before = execute(&definitions);
+    assert_eq!(before, value::Value::from_integer(42));
+    inline_program(&mut definitions);
+    // The call really was replaced by the callee's body…
+    let [Statement::Expr(Expression::Function { calls, .. })] =
+        definitions.function_definitions[1].body.as_slice()
+    else {
+        panic!("expected a single call body");
+    };
+    let [Call { arguments }] = calls.as_slice() else {
+        panic!("expected a single call");
+    };
+    assert!(matches!(
+        &arguments[1],
+        Expression::Function { candidates, .. }
+            if matches!(candidates.as_slice(), [Function::IAdd])
+    ));
+    // …without changing what the program computes.
+    assert_eq!(execute(&definitions), before);
+}
+
+#[test]
+fn keep_large_body() {
+    let mut definitions = Definitions::new();
+    // Function 0: a sum of enough literals to exceed the size threshold.
+    let mut body = Expression::Integer(0);
+    for _ in 0..MAX_INLINE_SIZE {
+        body = call(Function::IAdd, vec![body, Expression::Integer(1)]);
+    }
+    push(&mut definitions, function(0, 0, body));
+    // Function 1: g() = f().
+    push(
+        &mut definitions,
+        function(0, 0, call(Function::UserDefined(0), vec![])),
+    );
+    inline_program(&mut definitions);
+    let [Statement::Expr(Expression::Function { candidates, .. })] =
+        definitions.function_definitions[1].body.as_slice()
+    else {
+        panic!("expected a single call body");
+    };
+    assert!(matches!(candidates.as_slice(), [Function::UserDefined(0)]));
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * Flat memory layouts of structure values.
+ *
+ * A structure value is stored as a contiguous run of one-word slots:
+ * scalar fields (integers, floats, references, functions) take one word,
+ * and a field that is itself a structure is stored inline, flattened
+ * through nested applications of
+ * [`TyConstructor::Structure`](super::TyConstructor). A [`Layout`]
+ * resolves every field to its word offset and size once, at lowering
+ * time, so a field access is a base-plus-constant-offset read instead of
+ * a walk through [`Definitions::structures`](super::Definitions) per
+ * access.
+ *
+ * A structure that contains itself by value, directly or through other
+ * structures, has no finite flattened size; the recursion marks each
+ * structure while its layout is being computed and reports a
+ * [`LayoutError::RecursiveStructure`] when it reaches a marked one.
+ */
+
+use super::{head_constructor, Definitions, TyBuilder, TyConstructor};
+
+/**
+ * The resolved layout of one structure instantiation, in one-word slots.
+ */
+pub struct Layout {
+    /**
+     * The word offset of each field, indexed like
+     * [`Structure::fields_ty`](super::Structure).
+     */
+    pub field_offsets: Vec<usize>,
+    /**
+     * The size of each field in words.
+     */
+    pub field_sizes: Vec<usize>,
+    /**
+     * The total size in words: the sum of the field sizes.
+     */
+    pub size: usize,
+}
+
+/**
+ * An error found while computing structure layouts.
+ */
+#[derive(Debug, PartialEq)]
+pub enum LayoutError {
+    /**
+     * The structure with the given index contains itself by value,
+     * directly or through other structures, so its flattened size would
+     * be infinite.
+     */
+    RecursiveStructure { structure_index: usize },
+}
+
+/**
+ * Computes the layout of every structure that takes no type parameters.
+ * Generic structures get `None`; their layouts depend on the
+ * instantiation arguments and are computed by [`structure_layout`] when
+ * the arguments are known.
+ */
+pub fn layouts(definitions: &Definitions) -> Result<Vec<Option<Layout>>, LayoutError> {
+    let mut in_progress = vec![false; definitions.structures.len()];
+    definitions
+        .structures
+        .iter()
+        .enumerate()
+        .map(|(index, structure)| {
+            (structure.num_ty_parameters == 0)
+                .then(|| marked_structure_layout(definitions, index, &[], &mut in_progress))
+                .transpose()
+        })
+        .collect()
+}
+
+/**
+ * Computes the layout of the structure with index `structure_index`,
+ * instantiated with type arguments of the given sizes.
+ */
+pub fn structure_layout(
+    definitions: &Definitions,
+    structure_index: usize,
+    ty_argument_sizes: &[usize],
+) -> Result<Layout, LayoutError> {
+    let mut in_progress = vec![false; definitions.structures.len()];
+    marked_structure_layout(
+        definitions,
+        structure_index,
+        ty_argument_sizes,
+        &mut in_progress,
+    )
+}
+
+/**
+ * [`structure_layout`] with `in_progress` marking the structures whose
+ * layouts are being computed further up the recursion: reaching one of
+ * them again means the structure contains itself by value.
+ */
+fn marked_structure_layout(
+    definitions: &Definitions,
+    structure_index: usize,
+    ty_argument_sizes: &[usize],
+    in_progress: &mut [bool],
+) -> Result<Layout, LayoutError> {
+    if in_progress[structure_index] {
+        return Err(LayoutError::RecursiveStructure { structure_index });
+    }
+    in_progress[structure_index] = true;
+    let structure = &definitions.structures[structure_index];
+    let mut field_offsets = Vec::with_capacity(structure.fields_ty.len());
+    let mut field_sizes = Vec::with_capacity(structure.fields_ty.len());
+    let mut size = 0;
+    for field_ty in &structure.fields_ty {
+        field_offsets.push(size);
+        let field_size = marked_ty_size(definitions, field_ty, ty_argument_sizes, in_progress)?;
+        field_sizes.push(field_size);
+        size += field_size;
+    }
+    in_progress[structure_index] = false;
+    Ok(Layout {
+        field_offsets,
+        field_sizes,
+        size,
+    })
+}
+
+/**
+ * The size in words of a value of type `ty`, with
+ * [`TyBuilder::Parameter`]s resolved through `ty_argument_sizes`.
+ */
+pub fn ty_size(
+    definitions: &Definitions,
+    ty: &TyBuilder,
+    ty_argument_sizes: &[usize],
+) -> Result<usize, LayoutError> {
+    let mut in_progress = vec![false; definitions.structures.len()];
+    marked_ty_size(definitions, ty, ty_argument_sizes, &mut in_progress)
+}
+
+fn marked_ty_size(
+    definitions: &Definitions,
+    ty: &TyBuilder,
+    ty_argument_sizes: &[usize],
+    in_progress: &mut [bool],
+) -> Result<usize, LayoutError> {
+    match *ty {
+        TyBuilder::Constructor(ref constructor) => match *constructor {
+            TyConstructor::Structure(index) => {
+                Ok(marked_structure_layout(definitions, index, &[], in_progress)?.size)
+            }
+            // The empty tuple.
+            TyConstructor::Tuple => Ok(0),
+            _ => Ok(1),
+        },
+        TyBuilder::Parameter(index) => Ok(ty_argument_sizes[index]),
+        TyBuilder::Application {
+            ref constructor,
+            ref arguments,
+        } => match head_constructor(constructor) {
+            Some(TyConstructor::Structure(index)) => {
+                let argument_sizes: Vec<usize> = arguments
+                    .iter()
+                    .map(|argument| {
+                        marked_ty_size(definitions, argument, ty_argument_sizes, in_progress)
+                    })
+                    .collect::<Result<_, _>>()?;
+                Ok(marked_structure_layout(definitions, index, &argument_sizes, in_progress)?.size)
+            }
+            Some(TyConstructor::Tuple) => arguments
+                .iter()
+                .map(|argument| {
+                    marked_ty_size(definitions, argument, ty_argument_sizes, in_progress)
+                })
+                .sum(),
+            // References and functions are one pointer-sized word; a
+            // parameter-headed application is stored boxed, also one word.
+            _ => Ok(1),
+        },
+    }
+}
+
+mod tests;
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#![cfg(test)]
+
+use super::*;
+use crate::backend::{Structure, TyKind};
+
+/**
+ * Appends a structure with the given fields and returns its index.
+ */
+fn push_structure(
+    definitions: &mut Definitions,
+    num_ty_parameters: usize,
+    fields_ty: Vec<TyBuilder>,
+) -> usize {
+    definitions.structure_kinds.push(TyKind::Ty);
+    definitions.structures.push(Structure {
+        num_ty_parameters,
+        fields_ty,
+    });
+    definitions.structures.len() - 1
+}
+
+#[test]
+fn scalar_fields() {
+    let mut definitions = Definitions::new();
+    let point = push_structure(
+        &mut definitions,
+        0,
+        vec![
+            TyBuilder::Constructor(TyConstructor::Integer),
+            TyBuilder::Constructor(TyConstructor::Float),
+        ],
+    );
+    let layout = structure_layout(&definitions, point, &[]).unwrap();
+    assert_eq!(layout.field_offsets, [0, 1]);
+    assert_eq!(layout.field_sizes, [1, 1]);
+    assert_eq!(layout.size, 2);
+}
+
+#[test]
+fn nested_structure_is_flattened() {
+    let mut definitions = Definitions::new();
+    let point = push_structure(
+        &mut definitions,
+        0,
+        vec![
+            TyBuilder::Constructor(TyConstructor::Integer),
+            TyBuilder::Constructor(TyConstructor::Integer),
+        ],
+    );
+    let line = push_structure(
+        &mut definitions,
+        0,
+        vec![
+            TyBuilder::Constructor(TyConstructor::Structure(point)),
+            TyBuilder::Constructor(TyConstructor::Structure(point)),
+        ],
+    );
+    let layout = structure_layout(&definitions, line, &[]).unwrap();
+    assert_eq!(layout.field_offsets, [0, 2]);
+    assert_eq!(layout.field_sizes, [2, 2]);
+    assert_eq!(layout.size, 4);
+}
+
+#[test]
+fn instantiated_parameter_field() {
+    let mut definitions = Definitions::new();
+    let pair = push_structure(
+        &mut definitions,
+        1,
+        vec![
+            TyBuilder::Parameter(0),
+            TyBuilder::Constructor(TyConstructor::Integer),
+        ],
+    );
+    let layout = structure_layout(&definitions, pair, &[2]).unwrap();
+    assert_eq!(layout.field_offsets, [0, 2]);
+    assert_eq!(layout.field_sizes, [2, 1]);
+    assert_eq!(layout.size, 3);
+}
+
+#[test]
+fn reference_to_structure_is_one_word() {
+    let mut definitions = Definitions::new();
+    let point = push_structure(
+        &mut definitions,
+        0,
+        vec![
+            TyBuilder::Constructor(TyConstructor::Integer),
+            TyBuilder::Constructor(TyConstructor::Integer),
+        ],
+    );
+    let ty = TyBuilder::Application {
+        constructor: Box::new(TyBuilder::Constructor(TyConstructor::Reference)),
+        arguments: vec![TyBuilder::Constructor(TyConstructor::Structure(point))],
+    };
+    assert_eq!(ty_size(&definitions, &ty, &[]).unwrap(), 1);
+}
+
+#[test]
+fn generic_structures_have_no_precomputed_layout() {
+    let mut definitions = Definitions::new();
+    push_structure(
+        &mut definitions,
+        0,
+        vec![TyBuilder::Constructor(TyConstructor::Integer)],
+    );
+    push_structure(&mut definitions, 1, vec![TyBuilder::Parameter(0)]);
+    let layouts = layouts(&definitions).unwrap();
+    assert!(layouts[0].is_some());
+    assert!(layouts[1].is_none());
+}
+
+#[test]
+fn recursive_structure_is_rejected() {
+    let mut definitions = Definitions::new();
+    let list = push_structure(&mut definitions, 0, Vec::new());
+    definitions.structures[list].fields_ty = vec![
+        TyBuilder::Constructor(TyConstructor::Integer),
+        TyBuilder::Constructor(TyConstructor::Structure(list)),
+    ];
+    assert!(matches!(
+        layouts(&definitions),
+        Err(LayoutError::RecursiveStructure { structure_index }) if structure_index == list
+    ));
+}
+
+#[test]
+fn mutually_recursive_structures_are_rejected() {
+    let mut definitions = Definitions::new();
+    let first = push_structure(&mut definitions, 0, Vec::new());
+    let second = push_structure(
+        &mut definitions,
+        0,
+        vec![TyBuilder::Constructor(TyConstructor::Structure(first))],
+    );
+    definitions.structures[first].fields_ty =
+        vec![TyBuilder::Constructor(TyConstructor::Structure(second))];
+    assert!(matches!(
+        layouts(&definitions),
+        Err(LayoutError::RecursiveStructure { .. })
+    ));
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * Overload pruning by signature.
+ *
+ * A call site carries every candidate its name resolved to, and full
+ * resolution must unify against each of them. Most candidates lose on
+ * their [`Signature`] alone — wrong arity, or a parameter whose head
+ * constructor contradicts an argument known without type checking — so
+ * this pass drops them first, per call site, with no type nodes built.
+ * Pruning never empties a candidate set: when nothing matches, the set is
+ * left intact so resolution proper reports the mismatch. Calls that end up
+ * with a single candidate become visible to the [`inline`](super::inline)
+ * pass, so the pass runs before it.
+ */
+
+use super::{
+    builtin_signature, candidate_signatures, Definitions, Expression, Function, Signature,
+    Statement,
+};
+
+/**
+ * Prunes the candidate sets of every call in every function body.
+ */
+pub fn resolve_program(definitions: &mut Definitions) {
+    let signatures = candidate_signatures(&definitions.function_tys);
+    for definition in &mut definitions.function_definitions {
+        for statement in &mut definition.body {
+            resolve_statement(statement, &signatures);
+        }
+    }
+}
+
+fn resolve_statement(statement: &mut Statement, signatures: &[Signature]) {
+    match statement {
+        Statement::Empty => {}
+        Statement::Expr(expression) => resolve_expression(expression, signatures),
+        Statement::While(condition, body) => {
+            resolve_expression(condition, signatures);
+            for statement in body {
+                resolve_statement(statement, signatures);
+            }
+        }
+        Statement::Let(_, expression) => resolve_expression(expression, signatures),
+    }
+}
+
+fn resolve_expression(expression: &mut Expression, signatures: &[Signature]) {
+    let Expression::Function { candidates, calls } = expression else {
+        return;
+    };
+    for call in calls.iter_mut() {
+        for argument in &mut call.arguments {
+            resolve_expression(argument, signatures);
+        }
+    }
+    // A single candidate has nothing to lose, and a candidate set without a
+    // call has nothing to check against.
+    let Some(first_call) = calls.first() else {
+        return;
+    };
+    if candidates.len() < 2 {
+        return;
+    }
+    let surviving: Vec<Function> = candidates
+        .iter()
+        .filter(|candidate| {
+            let builtin;
+            let signature = match **candidate {
+                Function::UserDefined(index) => Some(&signatures[index]),
+                ref candidate => {
+                    builtin = builtin_signature(candidate);
+                    builtin.as_ref()
+                }
+            };
+            match signature {
+                Some(signature) => signature.matches(first_call),
+                None => true,
+            }
+        })
+        .cloned()
+        .collect();
+    if !surviving.is_empty() && surviving.len() < candidates.len() {
+        *candidates = surviving;
+    }
+}
+
+mod tests;
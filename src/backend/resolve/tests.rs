@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#![cfg(test)]
+
+use super::*;
+use crate::backend::{Call, FunctionDefinition, FunctionTy, TyBuilder, TyConstructor};
+
+/**
+ * A shorthand to build a signature taking the given parameter types.
+ */
+fn function_ty(parameters_ty: Vec<TyBuilder>) -> FunctionTy {
+    FunctionTy {
+        num_ty_parameters: 0,
+        parameters_ty,
+        return_ty: TyBuilder::Constructor(TyConstructor::Integer),
+    }
+}
+
+/**
+ * A program whose single body is one call of `candidates` with the given
+ * arguments; returns the candidates the call keeps after pruning.
+ */
+fn prune(
+    function_tys: Vec<FunctionTy>,
+    candidates: Vec<Function>,
+    arguments: Vec<Expression>,
+) -> Vec<Function> {
+    let mut definitions = Definitions::new();
+    for ty in function_tys {
+        definitions.push_function(
+            ty,
+            FunctionDefinition {
+                num_local_variables: 0,
+                body: Vec::new(),
+            },
+        );
+    }
+    definitions.push_function(
+        function_ty(Vec::new()),
+        FunctionDefinition {
+            num_local_variables: 0,
+            body: vec![Statement::Expr(Expression::Function {
+                candidates,
+                calls: vec![Call { arguments }],
+            })],
+        },
+    );
+    resolve_program(&mut definitions);
+    let Some(Statement::Expr(Expression::Function { candidates, .. })) = definitions
+        .function_definitions
+        .last()
+        .unwrap()
+        .body
+        .first()
+    else {
+        panic!("expected the call to survive as a call");
+    };
+    candidates.clone()
+}
+
+#[test]
+fn prune_by_arity() {
+    let kept = prune(
+        vec![
+            function_ty(vec![TyBuilder::Constructor(TyConstructor::Integer)]),
+            function_ty(vec![
+                TyBuilder::Constructor(TyConstructor::Integer),
+                TyBuilder::Constructor(TyConstructor::Integer),
+            ]),
+        ],
+        vec![Function::UserDefined(0), Function::UserDefined(1)],
+        vec![Expression::Integer(1)],
+    );
+    assert!(matches!(kept.as_slice(), [Function::UserDefined(0)]));
+}
+
+#[test]
+fn prune_by_head_constructor() {
+    let kept = prune(
+        vec![function_ty(vec![
+            TyBuilder::Constructor(TyConstructor::Float),
+            TyBuilder::Constructor(TyConstructor::Float),
+        ])],
+        vec![Function::IAdd, Function::UserDefined(0)],
+        vec![Expression::Integer(1), Expression::Integer(2)],
+    );
+    assert!(matches!(kept.as_slice(), [Function::IAdd]));
+}
+
+#[test]
+fn keep_candidates_with_unknown_argument_heads() {
+    // A dereferenced variable has no head constructor known up front, so
+    // neither candidate can be rejected.
+    let kept = prune(
+        vec![function_ty(vec![TyBuilder::Constructor(
+            TyConstructor::Float,
+        )])],
+        vec![Function::Deref, Function::UserDefined(0)],
+        vec![Expression::Function {
+            candidates: vec![Function::Deref],
+            calls: vec![Call {
+                arguments: vec![Expression::LocalVariable(0)],
+            }],
+        }],
+    );
+    assert_eq!(kept.len(), 2);
+}
+
+#[test]
+fn keep_all_when_nothing_matches() {
+    // An empty candidate set would lose the information resolution proper
+    // needs to report the mismatch.
+    let kept = prune(
+        vec![function_ty(vec![TyBuilder::Constructor(
+            TyConstructor::Float,
+        )])],
+        vec![Function::IAdd, Function::UserDefined(0)],
+        vec![Expression::Integer(1)],
+    );
+    assert_eq!(kept.len(), 2);
+}
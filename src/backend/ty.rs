@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * Defines [`TyArena`], the arena-backed representation of types during
+ * unification.
+ *
+ * Types are [`TyId`] indices into a flat `Vec` owned by the arena, so all
+ * types built while checking one module are freed in a single drop. An
+ * undetermined type is the root of a union-find class; binding it installs
+ * a [`TyNode::SameAs`] link, and [`TyArena::find`] follows links with path
+ * compression and union by rank, making repeated resolution near-O(α).
+ *
+ * Speculation — trying one overload candidate and undoing it on failure —
+ * is bracketed by [`TyArena::snapshot`] and [`TyArena::rollback`]. Every
+ * node carries the generation of the snapshot it was last written under,
+ * and a write only goes on the undo trail when its generation is older
+ * than the current snapshot's: nodes allocated or already rewritten during
+ * the attempt are skipped, so a rollback touches each node at most once no
+ * matter how many times unification rewrote it, and undoing an attempt
+ * that bound nothing pre-existing is O(1).
+ */
+
+use super::TyConstructor;
+
+/**
+ * An index into a [`TyArena`], identifying one type node.
+ */
+#[derive(Clone, Copy, PartialEq, Eq, Debug)]
+pub struct TyId(u32);
+
+/**
+ * A type node stored in a [`TyArena`].
+ */
+pub enum TyNode {
+    Constructor(TyConstructor),
+    Parameter(usize),
+    Application {
+        constructor: TyId,
+        arguments: TyId,
+    },
+    Nil,
+    Cons(TyId, TyId),
+    /**
+     * An unbound unification variable; the root of its union-find class.
+     */
+    Undetermined {
+        rank: u32,
+    },
+    /**
+     * A bound variable or a path-compressed link to another node.
+     */
+    SameAs(TyId),
+}
+
+/**
+ * An entry of the undo trail: the node at [`TyId`] was overwritten for the
+ * first time under the current snapshot and held the recorded [`TyNode`]
+ * and generation stamp before.
+ */
+pub struct TrailEntry {
+    id: TyId,
+    previous: TyNode,
+    previous_generation: u32,
+}
+
+/**
+ * A point to [`rollback`](TyArena::rollback) to, taken by
+ * [`snapshot`](TyArena::snapshot) before a speculative attempt.
+ */
+#[derive(Clone, Copy)]
+pub struct Snapshot {
+    trail_length: usize,
+    generation: u32,
+}
+
+/**
+ * The arena owning all [`TyNode`]s of one module.
+ */
+pub struct TyArena {
+    nodes: Vec<TyNode>,
+    /**
+     * The generation under which each node was last written, indexed like
+     * [`TyArena::nodes`]. A write is trailed only if the node's generation
+     * is older than [`TyArena::generation`].
+     */
+    generations: Vec<u32>,
+    /**
+     * The generation of the innermost active snapshot. Bumped by both
+     * [`snapshot`](Self::snapshot) and [`rollback`](Self::rollback), never
+     * reused, so a stamp can never be mistaken for the current generation
+     * after the snapshot that issued it is gone.
+     */
+    generation: u32,
+}
+
+impl TyArena {
+    pub fn new() -> TyArena {
+        TyArena {
+            nodes: Vec::new(),
+            generations: Vec::new(),
+            generation: 0,
+        }
+    }
+
+    /**
+     * Allocates a new node and returns its [`TyId`].
+     */
+    pub fn push(&mut self, node: TyNode) -> TyId {
+        crate::stats::count(crate::stats::Counter::TyCellsCreated, 1);
+        let id = TyId(self.nodes.len() as u32);
+        self.nodes.push(node);
+        self.generations.push(self.generation);
+        id
+    }
+
+    /**
+     * A shorthand to allocate a fresh undetermined type.
+     */
+    pub fn push_undetermined(&mut self) -> TyId {
+        self.push(TyNode::Undetermined { rank: 0 })
+    }
+
+    /**
+     * Returns the representative of `id`, following [`TyNode::SameAs`]
+     * links with path compression. Compressed links are recorded on the
+     * trail so that [`rollback`](Self::rollback) restores them.
+     */
+    pub fn find(&mut self, id: TyId, trail: &mut Vec<TrailEntry>) -> TyId {
+        let mut root = id;
+        while let TyNode::SameAs(next) = self.nodes[root.0 as usize] {
+            root = next;
+        }
+        let mut current = id;
+        while let TyNode::SameAs(next) = self.nodes[current.0 as usize] {
+            if next != root {
+                self.write(current, TyNode::SameAs(root), trail);
+            }
+            current = next;
+        }
+        root
+    }
+
+    /**
+     * Returns the node for `id`, which must be a representative returned by
+     * [`find`](Self::find).
+     */
+    pub fn node(&self, id: TyId) -> &TyNode {
+        &self.nodes[id.0 as usize]
+    }
+
+    /**
+     * Binds the representative `id` to `node`; a synonym of
+     * [`write`](Self::write) named for its use in [`unify`](Self::unify).
+     */
+    fn bind(&mut self, id: TyId, node: TyNode, trail: &mut Vec<TrailEntry>) {
+        self.write(id, node, trail);
+    }
+
+    /**
+     * Overwrites the node at `id`, recording the previous node on the
+     * trail unless `id` was already written under the current generation —
+     * then the trail already holds (or, for a node allocated during the
+     * current snapshot, does not need) its pre-snapshot state.
+     */
+    fn write(&mut self, id: TyId, node: TyNode, trail: &mut Vec<TrailEntry>) {
+        let previous = std::mem::replace(&mut self.nodes[id.0 as usize], node);
+        let previous_generation = self.generations[id.0 as usize];
+        if previous_generation < self.generation {
+            self.generations[id.0 as usize] = self.generation;
+            trail.push(TrailEntry {
+                id,
+                previous,
+                previous_generation,
+            });
+        }
+    }
+
+    /**
+     * The occurs check: whether the type rooted at `haystack` contains the
+     * representative `needle`.
+     */
+    fn contains(&mut self, haystack: TyId, needle: TyId, trail: &mut Vec<TrailEntry>) -> bool {
+        let haystack = self.find(haystack, trail);
+        if haystack == needle {
+            return true;
+        }
+        match self.nodes[haystack.0 as usize] {
+            TyNode::Constructor(_) => false,
+            TyNode::Parameter(_) => false,
+            TyNode::Application {
+                constructor,
+                arguments,
+            } => {
+                self.contains(constructor, needle, trail) || self.contains(arguments, needle, trail)
+            }
+            TyNode::Nil => false,
+            TyNode::Cons(head, tail) => {
+                self.contains(head, needle, trail) || self.contains(tail, needle, trail)
+            }
+            TyNode::Undetermined { .. } => false,
+            TyNode::SameAs(_) => unreachable!(),
+        }
+    }
+
+    /**
+     * Unifies the types rooted at `left` and `right`. On failure the
+     * caller should [`rollback`](Self::rollback) to the [`Snapshot`] it
+     * took beforehand.
+     */
+    pub fn unify(&mut self, left: TyId, right: TyId, trail: &mut Vec<TrailEntry>) -> bool {
+        crate::stats::count(crate::stats::Counter::UnifyCalls, 1);
+        let left = self.find(left, trail);
+        let right = self.find(right, trail);
+        if left == right {
+            return true;
+        }
+        match (&self.nodes[left.0 as usize], &self.nodes[right.0 as usize]) {
+            (
+                &TyNode::Undetermined { rank: left_rank },
+                &TyNode::Undetermined { rank: right_rank },
+            ) => {
+                // Union by rank: the shallower class joins the deeper one.
+                let (child, root) = if left_rank < right_rank {
+                    (left, right)
+                } else {
+                    (right, left)
+                };
+                if left_rank == right_rank {
+                    self.bind(
+                        root,
+                        TyNode::Undetermined {
+                            rank: left_rank + 1,
+                        },
+                        trail,
+                    );
+                }
+                self.bind(child, TyNode::SameAs(root), trail);
+                true
+            }
+            (TyNode::Undetermined { .. }, _) => {
+                if self.contains(right, left, trail) {
+                    return false;
+                }
+                self.bind(left, TyNode::SameAs(right), trail);
+                true
+            }
+            (_, TyNode::Undetermined { .. }) => {
+                if self.contains(left, right, trail) {
+                    return false;
+                }
+                self.bind(right, TyNode::SameAs(left), trail);
+                true
+            }
+            (TyNode::Constructor(left_constructor), TyNode::Constructor(right_constructor)) => {
+                left_constructor == right_constructor
+            }
+            (&TyNode::Parameter(left_index), &TyNode::Parameter(right_index)) => {
+                left_index == right_index
+            }
+            (TyNode::Nil, TyNode::Nil) => true,
+            (&TyNode::Cons(left_head, left_tail), &TyNode::Cons(right_head, right_tail)) => {
+                self.unify(left_head, right_head, trail) && self.unify(left_tail, right_tail, trail)
+            }
+            (
+                &TyNode::Application {
+                    constructor: left_constructor,
+                    arguments: left_arguments,
+                },
+                &TyNode::Application {
+                    constructor: right_constructor,
+                    arguments: right_arguments,
+                },
+            ) => {
+                self.unify(left_constructor, right_constructor, trail)
+                    && self.unify(left_arguments, right_arguments, trail)
+            }
+            _ => false,
+        }
+    }
+
+    /**
+     * Opens a new generation and returns the [`Snapshot`] that
+     * [`rollback`](Self::rollback) undoes to. Writes under the new
+     * generation are trailed once per node; nodes allocated after the
+     * snapshot are never trailed at all, since undoing the attempt makes
+     * them unreachable.
+     */
+    pub fn snapshot(&mut self, trail: &[TrailEntry]) -> Snapshot {
+        self.generation += 1;
+        Snapshot {
+            trail_length: trail.len(),
+            generation: self.generation,
+        }
+    }
+
+    /**
+     * Undoes every binding recorded since `snapshot` was taken, restoring
+     * each written node and its generation stamp, and opens a fresh
+     * generation so that later writes are trailed against the enclosing
+     * snapshot again.
+     */
+    pub fn rollback(&mut self, trail: &mut Vec<TrailEntry>, snapshot: Snapshot) {
+        crate::stats::count(crate::stats::Counter::RollbackCalls, 1);
+        debug_assert!(snapshot.generation <= self.generation);
+        while trail.len() > snapshot.trail_length {
+            let TrailEntry {
+                id,
+                previous,
+                previous_generation,
+            } = trail.pop().unwrap();
+            self.nodes[id.0 as usize] = previous;
+            self.generations[id.0 as usize] = previous_generation;
+        }
+        self.generation += 1;
+    }
+}
+
+mod tests;
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#![cfg(test)]
+
+use super::*;
+
+#[test]
+fn rollback_restores_undetermined() {
+    let mut arena = TyArena::new();
+    let mut trail = Vec::new();
+    let variable = arena.push_undetermined();
+    let integer = arena.push(TyNode::Constructor(TyConstructor::Integer));
+    let snapshot = arena.snapshot(&trail);
+    assert!(arena.unify(variable, integer, &mut trail));
+    let root = arena.find(variable, &mut trail);
+    assert!(matches!(
+        arena.node(root),
+        TyNode::Constructor(TyConstructor::Integer)
+    ));
+    arena.rollback(&mut trail, snapshot);
+    let root = arena.find(variable, &mut trail);
+    assert!(matches!(arena.node(root), TyNode::Undetermined { .. }));
+}
+
+#[test]
+fn mismatched_constructors_leave_trail_empty() {
+    let mut arena = TyArena::new();
+    let mut trail = Vec::new();
+    let integer = arena.push(TyNode::Constructor(TyConstructor::Integer));
+    let float = arena.push(TyNode::Constructor(TyConstructor::Float));
+    let _snapshot = arena.snapshot(&trail);
+    assert!(!arena.unify(integer, float, &mut trail));
+    assert!(trail.is_empty());
+}
+
+#[test]
+fn nodes_allocated_after_snapshot_are_not_trailed() {
+    let mut arena = TyArena::new();
+    let mut trail = Vec::new();
+    let snapshot = arena.snapshot(&trail);
+    let variable = arena.push_undetermined();
+    let integer = arena.push(TyNode::Constructor(TyConstructor::Integer));
+    assert!(arena.unify(variable, integer, &mut trail));
+    assert!(trail.is_empty());
+    arena.rollback(&mut trail, snapshot);
+}
+
+#[test]
+fn node_is_trailed_once_per_snapshot() {
+    let mut arena = TyArena::new();
+    let mut trail = Vec::new();
+    let left = arena.push_undetermined();
+    let right = arena.push_undetermined();
+    let integer = arena.push(TyNode::Constructor(TyConstructor::Integer));
+    let snapshot = arena.snapshot(&trail);
+    // Binds both pre-existing variables: one rank bump and one link.
+    assert!(arena.unify(left, right, &mut trail));
+    assert_eq!(trail.len(), 2);
+    // Rebinds the shared root, which is already trailed: no new entry.
+    assert!(arena.unify(left, integer, &mut trail));
+    assert_eq!(trail.len(), 2);
+    arena.rollback(&mut trail, snapshot);
+    let left_root = arena.find(left, &mut trail);
+    let right_root = arena.find(right, &mut trail);
+    assert_ne!(left_root, right_root);
+    assert!(matches!(arena.node(left_root), TyNode::Undetermined { .. }));
+    assert!(matches!(
+        arena.node(right_root),
+        TyNode::Undetermined { .. }
+    ));
+}
+
+#[test]
+fn nested_snapshots_roll_back_independently() {
+    let mut arena = TyArena::new();
+    let mut trail = Vec::new();
+    let first = arena.push_undetermined();
+    let second = arena.push_undetermined();
+    let integer = arena.push(TyNode::Constructor(TyConstructor::Integer));
+    let float = arena.push(TyNode::Constructor(TyConstructor::Float));
+    let outer = arena.snapshot(&trail);
+    assert!(arena.unify(first, integer, &mut trail));
+    let inner = arena.snapshot(&trail);
+    assert!(arena.unify(second, first, &mut trail));
+    arena.rollback(&mut trail, inner);
+    // The inner attempt is undone, the outer binding survives.
+    let second_root = arena.find(second, &mut trail);
+    assert!(matches!(
+        arena.node(second_root),
+        TyNode::Undetermined { .. }
+    ));
+    let first_root = arena.find(first, &mut trail);
+    assert!(matches!(
+        arena.node(first_root),
+        TyNode::Constructor(TyConstructor::Integer)
+    ));
+    assert!(arena.unify(second, float, &mut trail));
+    arena.rollback(&mut trail, outer);
+    let first_root = arena.find(first, &mut trail);
+    let second_root = arena.find(second, &mut trail);
+    assert!(matches!(
+        arena.node(first_root),
+        TyNode::Undetermined { .. }
+    ));
+    assert!(matches!(
+        arena.node(second_root),
+        TyNode::Undetermined { .. }
+    ));
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * The runtime representation of values: a single 8-byte NaN-boxed word.
+ *
+ * A [`Value`] is the bit pattern of an `f64`. Every float is stored as
+ * itself, except that NaNs are canonicalized on the way in; integers and
+ * references live in the part of the NaN space no canonicalized float can
+ * occupy, distinguished by the top 16 bits and carrying a 48-bit payload.
+ * Arithmetic temporaries therefore never allocate, and the local variable
+ * slots of a call ([`FunctionDefinition::num_local_variables`]
+ * (../struct.FunctionDefinition.html)) are a flat [`Frame`] of words.
+ * Tuples and structures are one reference word to a [`Heap`] cell holding
+ * their flat slots.
+ */
+
+/**
+ * An 8-byte word holding a float, an integer, or a reference.
+ */
+#[derive(Clone, Copy, PartialEq, Eq)]
+pub struct Value(u64);
+
+/**
+ * The quiet NaN every float NaN is canonicalized to. Its top 16 bits are
+ * `0x7FF8`, so it never collides with the tags below.
+ */
+const CANONICAL_NAN: u64 = 0x7FF8_0000_0000_0000;
+/**
+ * The top 16 bits distinguishing non-float values. Tags have the sign bit
+ * set, which canonicalized NaNs never do.
+ */
+const TAG_MASK: u64 = 0xFFFF_0000_0000_0000;
+const TAG_INTEGER: u64 = 0xFFFC_0000_0000_0000;
+const TAG_REFERENCE: u64 = 0xFFFE_0000_0000_0000;
+
+/**
+ * The bounds of the 48-bit two's complement payload of an integer.
+ */
+pub const MIN_INTEGER: i64 = -(1 << 47);
+pub const MAX_INTEGER: i64 = (1 << 47) - 1;
+
+impl Value {
+    pub fn from_float(value: f64) -> Value {
+        if value.is_nan() {
+            Value(CANONICAL_NAN)
+        } else {
+            Value(value.to_bits())
+        }
+    }
+    pub fn is_float(self) -> bool {
+        self.0 & TAG_MASK != TAG_INTEGER && self.0 & TAG_MASK != TAG_REFERENCE
+    }
+    pub fn to_float(self) -> f64 {
+        debug_assert!(self.is_float());
+        f64::from_bits(self.0)
+    }
+    /**
+     * Boxes `value`, which must fit in the 48-bit payload. Wider integers
+     * will be stored behind a reference once the execution engine lands.
+     */
+    pub fn from_integer(value: i64) -> Value {
+        assert!((MIN_INTEGER..=MAX_INTEGER).contains(&value));
+        Value(TAG_INTEGER | (value as u64 & !TAG_MASK))
+    }
+    pub fn is_integer(self) -> bool {
+        self.0 & TAG_MASK == TAG_INTEGER
+    }
+    pub fn to_integer(self) -> i64 {
+        debug_assert!(self.is_integer());
+        ((self.0 << 16) as i64) >> 16
+    }
+    /**
+     * Boxes a pointer to a value slot, as created by
+     * [`Instruction::PushLocalRef`](../code/enum.Instruction.html) and
+     * consumed by [`Instruction::Deref`](../code/enum.Instruction.html).
+     */
+    pub fn from_reference(target: *mut Value) -> Value {
+        debug_assert!(target as u64 & TAG_MASK == 0);
+        Value(TAG_REFERENCE | target as u64)
+    }
+    pub fn is_reference(self) -> bool {
+        self.0 & TAG_MASK == TAG_REFERENCE
+    }
+    pub fn to_reference(self) -> *mut Value {
+        debug_assert!(self.is_reference());
+        (self.0 & !TAG_MASK) as *mut Value
+    }
+}
+
+impl std::fmt::Debug for Value {
+    fn fmt(&self, formatter: &mut std::fmt::Formatter) -> std::fmt::Result {
+        if self.is_integer() {
+            write!(formatter, "Integer({})", self.to_integer())
+        } else if self.is_reference() {
+            write!(formatter, "Reference({:p})", self.to_reference())
+        } else {
+            write!(formatter, "Float({})", self.to_float())
+        }
+    }
+}
+
+/**
+ * The local variable slots of one call, stored as a flat array of words.
+ */
+pub struct Frame {
+    slots: Box<[Value]>,
+}
+
+impl Frame {
+    /**
+     * Allocates `num_local_variables` slots, each holding the canonical
+     * NaN until the function body assigns it.
+     */
+    pub fn new(num_local_variables: usize) -> Frame {
+        Frame {
+            slots: vec![Value(CANONICAL_NAN); num_local_variables].into(),
+        }
+    }
+    pub fn get(&self, index: usize) -> Value {
+        self.slots[index]
+    }
+    pub fn set(&mut self, index: usize, value: Value) {
+        self.slots[index] = value;
+    }
+    /**
+     * A pointer to slot `index`, stable for as long as the frame lives:
+     * the slots are their own heap allocation, so moving the [`Frame`]
+     * does not move them.
+     */
+    pub fn slot_ptr(&mut self, index: usize) -> *mut Value {
+        &mut self.slots[index]
+    }
+}
+
+/**
+ * The cells behind structure values. A tuple or structure is one word, a
+ * reference to a heap cell holding its flat slots; the heap keeps every
+ * cell alive until it is dropped, so the references it hands out stay
+ * valid for a whole execution.
+ */
+pub struct Heap {
+    cells: Vec<Box<[Value]>>,
+}
+
+impl Heap {
+    pub fn new() -> Heap {
+        Heap { cells: Vec::new() }
+    }
+    /**
+     * Allocates a cell holding `words` and returns a reference to its
+     * first word.
+     */
+    pub fn alloc(&mut self, words: Vec<Value>) -> Value {
+        let mut cell: Box<[Value]> = words.into();
+        let reference = Value::from_reference(cell.as_mut_ptr());
+        self.cells.push(cell);
+        reference
+    }
+}
+
+mod tests;
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#![cfg(test)]
+
+use super::*;
+
+#[test]
+fn value_is_one_word() {
+    assert_eq!(std::mem::size_of::<Value>(), 8);
+}
+
+#[test]
+fn float_round_trip() {
+    for float in [0.0, -0.0, 1.5, -2.5e300, f64::INFINITY, f64::NEG_INFINITY] {
+        let value = Value::from_float(float);
+        assert!(value.is_float());
+        assert!(!value.is_integer());
+        assert!(!value.is_reference());
+        assert_eq!(value.to_float().to_bits(), float.to_bits());
+    }
+}
+
+#[test]
+fn nan_is_canonicalized() {
+    let value = Value::from_float(f64::from_bits(TAG_INTEGER | 42));
+    assert!(value.is_float());
+    assert!(value.to_float().is_nan());
+}
+
+#[test]
+fn integer_round_trip() {
+    for integer in [0, 1, -1, 123_456_789, MIN_INTEGER, MAX_INTEGER] {
+        let value = Value::from_integer(integer);
+        assert!(value.is_integer());
+        assert!(!value.is_float());
+        assert_eq!(value.to_integer(), integer);
+    }
+}
+
+#[test]
+#[should_panic]
+fn out_of_range_integer_is_rejected() {
+    Value::from_integer(MAX_INTEGER + 1);
+}
+
+#[test]
+fn reference_round_trip() {
+    let mut slot = Value::from_integer(7);
+    let value = Value::from_reference(&mut slot);
+    assert!(value.is_reference());
+    assert!(!value.is_float());
+    assert_eq!(value.to_reference(), &mut slot as *mut Value);
+}
+
+#[test]
+fn frame_slots() {
+    let mut frame = Frame::new(2);
+    assert!(frame.get(0).to_float().is_nan());
+    frame.set(1, Value::from_integer(5));
+    assert_eq!(frame.get(1).to_integer(), 5);
+    unsafe { *frame.slot_ptr(1) = Value::from_integer(6) };
+    assert_eq!(frame.get(1).to_integer(), 6);
+}
+
+#[test]
+fn heap_cell_keeps_words_alive() {
+    let mut heap = Heap::new();
+    let cell = heap.alloc(vec![Value::from_integer(1), Value::from_integer(2)]);
+    assert!(cell.is_reference());
+    let words = cell.to_reference();
+    assert_eq!(unsafe { *words }.to_integer(), 1);
+    assert_eq!(unsafe { *words.add(1) }.to_integer(), 2);
+}
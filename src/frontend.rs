@@ -16,54 +16,151 @@
  * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
  */
 
-mod ast;
-mod chars_peekable;
+pub mod ast;
+mod cache;
+pub mod chars_peekable;
+mod interner;
 
 use std::collections::{HashMap, HashSet};
-use std::io::Read;
 use std::path::{Path, PathBuf};
+use std::sync::{Condvar, Mutex};
 
+use crate::source::Source;
 use crate::{backend, log};
 use chars_peekable::CharsPeekable;
+use interner::Symbol;
 
 /**
  * Reads the file specified by `root_file_path` and any other files it
- * imports, and passes them to `backend`.
+ * imports, and passes them to `backend`. A shorthand for compiling once in
+ * a fresh [`Session`].
  */
 pub fn read_input(root_file_path: &Path) -> Result<backend::Definitions, ()> {
-    let root_file_path = root_file_path.with_extension("sysc");
-    let root_file_path = match root_file_path.canonicalize() {
-        Ok(path) => path,
-        Err(err) => {
-            log::root_file_not_found(&root_file_path, err);
-            return Err(());
+    Session::new().compile(root_file_path)
+}
+
+/**
+ * State kept warm between compilations.
+ *
+ * A one-shot invocation creates a [`Session`], compiles and exits, but a
+ * long-lived process — the `--server` mode — reuses one session for every
+ * request, so the memory-mapped module files of shared imports stay
+ * resident instead of being reopened and re-validated per invocation.
+ * Compilations may also run concurrently against one session — the batch
+ * driver compiles several entry points at once — since the module store
+ * is internally locked; two compilations racing to a missed import
+ * translate it twice, and the later recording wins. The
+ * interner is process-wide and stays warm either way. Each
+ * [`compile`](Self::compile) still hashes every source file it reaches
+ * against the module cache, so editing a file between requests is picked
+ * up; module files rewritten by another process behind a running session
+ * are not.
+ */
+pub struct Session {
+    /**
+     * The store of per-file binary modules, shared by every compilation of
+     * this session.
+     */
+    cache: cache::Cache,
+}
+
+impl Session {
+    pub fn new() -> Session {
+        Session {
+            cache: cache::Cache::new(),
         }
-    };
-    let mut reader = Reader {
-        num_structures: 0,
-        num_functions: 0,
-        definitions: backend::Definitions::builtin(),
-        exported_items: Vec::new(),
-        files: Vec::new(),
-        file_indices: HashMap::new(),
-        import_chain: HashSet::from([root_file_path.clone()]),
-        num_errors: 0,
-    };
-    if let Err(err) = reader.read_file(&root_file_path) {
-        log::cannot_read_root_file(&root_file_path, err);
-        reader.num_errors += 1;
     }
-    if reader.num_errors > 0 {
-        log::aborting(reader.num_errors);
-        return Err(());
+
+    /**
+     * Reads the file specified by `root_file_path` and any other files it
+     * imports, and passes them to `backend`. Diagnostics are flushed
+     * before this returns, so a server can answer one request per call.
+     */
+    pub fn compile(&self, root_file_path: &Path) -> Result<backend::Definitions, ()> {
+        self.compile_watched(root_file_path).0
+    }
+
+    /**
+     * Compiles like [`compile`](Self::compile), and additionally returns
+     * every file the compilation discovered — including files that failed
+     * to read or parse — so a watcher knows which paths can invalidate the
+     * result.
+     */
+    pub fn compile_watched(
+        &self,
+        root_file_path: &Path,
+    ) -> (Result<backend::Definitions, ()>, Vec<PathBuf>) {
+        let root_file_path = root_file_path.with_extension("sysc");
+        let root_file_path = match root_file_path.canonicalize() {
+            Ok(path) => path,
+            Err(err) => {
+                log::root_file_not_found(&root_file_path, err);
+                log::flush();
+                return (Err(()), vec![root_file_path]);
+            }
+        };
+        let cache = &self.cache;
+        let pipeline = ParsePipeline::new(&root_file_path);
+        let num_workers = std::thread::available_parallelism().map_or(1, std::num::NonZero::get);
+        let (num_errors, definitions) = std::thread::scope(|scope| {
+            for _ in 0..num_workers {
+                scope.spawn(|| pipeline.work(cache));
+            }
+            let mut reader = Reader {
+                num_structures: 0,
+                num_functions: 0,
+                definitions: backend::Definitions::new(),
+                pipeline: &pipeline,
+                cache,
+                exported_items: Vec::new(),
+                files: Vec::new(),
+                file_indices: HashMap::new(),
+                file_keys: Vec::new(),
+                import_chain: HashSet::from([root_file_path.clone()]),
+                num_errors: 0,
+            };
+            if let Err(err) = reader.read_file(&root_file_path) {
+                log::cannot_read_root_file(&root_file_path, err);
+                reader.num_errors += 1;
+            }
+            (reader.num_errors, reader.definitions)
+        });
+        let watched_files: Vec<PathBuf> = pipeline
+            .state
+            .into_inner()
+            .unwrap()
+            .seen
+            .into_iter()
+            .collect();
+        log::flush();
+        if num_errors > 0 {
+            log::aborting(num_errors);
+            return (Err(()), watched_files);
+        }
+        let mut definitions = definitions;
+        crate::stats::time(crate::stats::Phase::Resolve, || {
+            backend::resolve::resolve_program(&mut definitions)
+        });
+        crate::stats::time(crate::stats::Phase::Inline, || {
+            backend::inline::inline_program(&mut definitions)
+        });
+        crate::stats::time(crate::stats::Phase::Hoist, || {
+            backend::hoist::hoist_program(&mut definitions)
+        });
+        (Ok(definitions), watched_files)
+    }
+}
+
+impl Default for Session {
+    fn default() -> Session {
+        Session::new()
     }
-    Ok(reader.definitions)
 }
 
 /**
- * A structure used in [`read_input`].
+ * A structure used in [`Session::compile`].
  */
-struct Reader {
+struct Reader<'a> {
     /**
      * Total number of structures defined in all files. Used and updated by
      * [`register_structure_name`].
@@ -78,10 +175,24 @@ struct Reader {
      * The target which [`Reader::read_file`] stores the results in.
      */
     definitions: backend::Definitions,
+    /**
+     * The pipeline whose workers read and parse files while translation
+     * runs. [`Reader::read_file`] collects each file from it, blocking
+     * only if the file it needs next has not been parsed yet.
+     */
+    pipeline: &'a ParsePipeline,
+    /**
+     * The store of per-file binary modules. Consulted by
+     * [`Reader::read_file`] before translating a file, and refreshed after
+     * translating one cleanly. Shared with the [`ParsePipeline`] workers,
+     * which use the recorded import paths to keep discovery going without
+     * parsing.
+     */
+    cache: &'a cache::Cache,
     /**
      * Items exported from each file.
      */
-    exported_items: Vec<HashMap<String, Item>>,
+    exported_items: Vec<HashMap<Symbol, Item>>,
     /**
      * Debug information of each file.
      */
@@ -91,6 +202,14 @@ struct Reader {
      * times.
      */
     file_indices: HashMap<PathBuf, usize>,
+    /**
+     * The validation key of each file, indexed like [`Reader::file_indices`]
+     * values. A file's key folds its content hash with the keys of its
+     * imports and the index bases it was translated at, so a cache record is
+     * replayed only if every global index it baked in still comes out the
+     * same.
+     */
+    file_keys: Vec<u64>,
     /**
      * Used in [`Reader::import_file`] to detect circular imports.
      */
@@ -101,7 +220,258 @@ struct Reader {
     num_errors: u32,
 }
 
-impl Reader {
+/**
+ * A file read and parsed by a [`ParsePipeline`] worker, waiting for
+ * translation.
+ */
+struct ParsedFile {
+    /**
+     * Debug information of the file.
+     */
+    file: log::File,
+    /**
+     * The parsed AST, or the I/O or parse error encountered producing it.
+     */
+    result: Result<ast::File, ReadError>,
+}
+
+/**
+ * An error which prevented a [`ParsePipeline`] worker from producing an
+ * AST.
+ */
+enum ReadError {
+    Io(std::io::Error),
+    Parse(Vec<log::ParseError>),
+}
+
+/**
+ * Reads and parses the root file and, transitively, every file it imports,
+ * concurrently with translation.
+ *
+ * Parsing one file is independent of every other file, so the import graph
+ * is walked by a pool of worker threads sharing a queue: each worker pops a
+ * path, reads and parses it, resolves its import targets, and enqueues any
+ * newly discovered files. Translation, which assigns global indices, stays
+ * sequential in [`Reader::read_file`] and runs alongside the workers,
+ * collecting each file with [`ParsePipeline::take`] as it reaches it. It
+ * blocks only when the one file it needs next is not parsed yet, so disk
+ * and parse latency overlaps with translation instead of preceding it.
+ *
+ * Diagnostics are not reported here: [`Reader::read_file`] revisits each
+ * import in deterministic order and reports errors there, so malformed
+ * import targets are simply skipped during discovery.
+ *
+ * Files with a cache record for their current contents are not parsed;
+ * their recorded import paths keep the discovery going. Whether the record
+ * is actually replayable is only decided later by
+ * [`Reader::splice_cached_file`], which falls back to parsing the file
+ * itself if not.
+ */
+struct ParsePipeline {
+    state: Mutex<PipelineState>,
+    state_changed: Condvar,
+}
+
+/**
+ * The queue shared between the [`ParsePipeline`] workers and
+ * [`ParsePipeline::take`], guarded by [`ParsePipeline::state`].
+ */
+struct PipelineState {
+    /**
+     * Discovered files not yet claimed by a worker.
+     */
+    pending: Vec<PathBuf>,
+    /**
+     * Every file ever enqueued, to enqueue each file only once.
+     */
+    seen: HashSet<PathBuf>,
+    /**
+     * Number of workers currently reading or parsing a file.
+     */
+    num_running: usize,
+    /**
+     * Parsed files not yet collected by [`ParsePipeline::take`].
+     */
+    results: HashMap<PathBuf, ParsedFile>,
+    /**
+     * Whether the workers have run out of work and exited.
+     */
+    finished: bool,
+}
+
+impl ParsePipeline {
+    fn new(root_file_path: &Path) -> ParsePipeline {
+        ParsePipeline {
+            state: Mutex::new(PipelineState {
+                pending: vec![root_file_path.to_path_buf()],
+                seen: HashSet::from([root_file_path.to_path_buf()]),
+                num_running: 0,
+                results: HashMap::new(),
+                finished: false,
+            }),
+            state_changed: Condvar::new(),
+        }
+    }
+    /**
+     * The worker loop: repeatedly claims a pending file, reads and parses
+     * it, and enqueues its newly discovered imports, until no file is
+     * pending and no other worker is running.
+     */
+    fn work(&self, cache: &cache::Cache) {
+        loop {
+            let path = {
+                let mut state = self.state.lock().unwrap();
+                loop {
+                    if let Some(path) = state.pending.pop() {
+                        state.num_running += 1;
+                        break path;
+                    }
+                    if state.num_running == 0 {
+                        state.finished = true;
+                        self.state_changed.notify_all();
+                        return;
+                    }
+                    state = self.state_changed.wait(state).unwrap();
+                }
+            };
+            if let Some(import_paths) = cached_import_paths(&path, cache) {
+                let mut state = self.state.lock().unwrap();
+                for import_path in import_paths {
+                    if state.seen.insert(import_path.clone()) {
+                        state.pending.push(import_path);
+                    }
+                }
+                state.num_running -= 1;
+                self.state_changed.notify_all();
+                continue;
+            }
+            let parsed_file = parse_single_file(&path);
+            let mut state = self.state.lock().unwrap();
+            if let Ok(ast) = &parsed_file.result {
+                for import in &ast.imports {
+                    let Some(import_path) =
+                        import_target_path(import, &ast.terms, path.parent().unwrap())
+                    else {
+                        continue;
+                    };
+                    if state.seen.insert(import_path.clone()) {
+                        state.pending.push(import_path);
+                    }
+                }
+            }
+            state.results.insert(path, parsed_file);
+            state.num_running -= 1;
+            self.state_changed.notify_all();
+        }
+    }
+    /**
+     * Collects the parsed `path`, blocking while a worker may still
+     * deliver it. Returns `None` once the workers have finished without
+     * producing it, which happens for files whose cache record supplied
+     * the import paths; the caller parses those itself if the record turns
+     * out not to be replayable.
+     */
+    fn take(&self, path: &Path) -> Option<ParsedFile> {
+        let mut state = self.state.lock().unwrap();
+        loop {
+            if let Some(parsed_file) = state.results.remove(path) {
+                return Some(parsed_file);
+            }
+            if state.finished {
+                return None;
+            }
+            state = self.state_changed.wait(state).unwrap();
+        }
+    }
+}
+
+/**
+ * Returns the import paths recorded in the cache for the current contents
+ * of `path`, or `None` if the file is unreadable or has no record. Called
+ * by the workers of a [`ParsePipeline`].
+ */
+fn cached_import_paths(path: &Path, cache: &cache::Cache) -> Option<Vec<PathBuf>> {
+    let source = Source::read(path).ok()?;
+    let (_, import_paths) = cache.header(path, cache::hash_bytes(source.as_bytes()))?;
+    Some(import_paths)
+}
+
+/**
+ * Reads and parses a single file. Called by the workers of a
+ * [`ParsePipeline`].
+ */
+fn parse_single_file(path: &Path) -> ParsedFile {
+    let source = match Source::read(path) {
+        Ok(source) => source,
+        Err(err) => {
+            return ParsedFile {
+                file: log::File::new(path.to_path_buf(), Source::empty()),
+                result: Err(ReadError::Io(err)),
+            }
+        }
+    };
+    let mut chars_peekable = CharsPeekable::new(&source);
+    let start = std::time::Instant::now();
+    let result = ast::parse_file(&mut chars_peekable).map_err(ReadError::Parse);
+    crate::stats::record_parse(path, start.elapsed());
+    if let Ok(ast) = &result {
+        crate::stats::count(
+            crate::stats::Counter::TermsAllocated,
+            ast.terms.len() as u64,
+        );
+    }
+    ParsedFile {
+        file: log::File::new(path.to_path_buf(), source),
+        result,
+    }
+}
+
+/**
+ * Resolves the target of `import` to the canonicalized path of the imported
+ * file, without reporting diagnostics. Malformed targets yield `None` and
+ * are reported later by [`Reader::import_file`].
+ */
+fn import_target_path(
+    import: &ast::Import,
+    terms: &ast::TermArena,
+    parent_directory: &Path,
+) -> Option<PathBuf> {
+    if import.extra_tokens_pos.is_some() {
+        return None;
+    }
+    let target = &terms[import.target?];
+    let path = match &target.term {
+        ast::Term::Identifier(name) => parent_directory.join(name.as_str()),
+        ast::Term::FunctionCall {
+            function,
+            arguments,
+        } => {
+            let ast::Term::Identifier(_) = terms[*function].term else {
+                return None;
+            };
+            match arguments.first()? {
+                ast::ListElement::NonEmpty(argument) => match &terms[*argument].term {
+                    ast::Term::StringLiteral(components) => {
+                        let mut path = String::new();
+                        for component in components {
+                            match component {
+                                ast::StringLiteralComponent::String(value) => path.push_str(value),
+                                ast::StringLiteralComponent::PlaceHolder { .. } => return None,
+                            }
+                        }
+                        parent_directory.join(&path)
+                    }
+                    _ => return None,
+                },
+                ast::ListElement::Empty { .. } => return None,
+            }
+        }
+        _ => return None,
+    };
+    path.with_extension("sysc").canonicalize().ok()
+}
+
+impl Reader<'_> {
     fn read_file(&mut self, path: &Path) -> Result<usize, std::io::Error> {
         if let Some(&index) = self.file_indices.get(path) {
             // The file specified by `path` was already read.
@@ -109,26 +479,44 @@ impl Reader {
             // this is not circular imports but diamond imports.
             return Ok(index);
         }
-        let mut file = std::fs::File::open(path)?;
-        let mut content = String::new();
-        file.read_to_string(&mut content)?;
-        let mut chars_peekable = CharsPeekable::new(&content);
-        let result = ast::parse_file(&mut chars_peekable);
-        let file = log::File {
-            path: path.to_path_buf(),
-            lines: chars_peekable.lines(),
-            content,
+        if let Some(index) = self.splice_cached_file(path) {
+            return Ok(index);
+        }
+        let ParsedFile { file, result } = match self.pipeline.take(path) {
+            Some(parsed_file) => parsed_file,
+            None => parse_single_file(path),
+        };
+        let result = match result {
+            Err(ReadError::Io(err)) => return Err(err),
+            Err(ReadError::Parse(err)) => Err(err),
+            Ok(ast) => Ok(ast),
         };
-        match result {
+        let file_key = match result {
             Ok(ast) => {
+                let content_hash = cache::hash_bytes(file.content.as_bytes());
+                let mut key = cache::KeyHasher::new();
+                key.write(content_hash);
+                let terms = ast.terms;
                 let mut named_items = HashMap::new();
+                let mut import_indices = Vec::new();
                 for import in ast.imports {
                     if let Ok((name, index)) =
-                        self.import_file(import, path.parent().unwrap(), &file)
+                        self.import_file(import, &terms, path.parent().unwrap(), &file)
                     {
                         named_items.insert(name, Item::Import(index));
+                        key.write(index as u64);
+                        key.write(self.file_keys[index]);
+                        import_indices.push(index);
                     }
                 }
+                key.write(self.num_structures as u64);
+                key.write(self.num_functions as u64);
+                key.write(self.definitions.structures.len() as u64);
+                key.write(self.definitions.function_tys.len() as u64);
+                let structure_names_base = self.num_structures;
+                let function_names_base = self.num_functions;
+                let structures_base = self.definitions.structures.len();
+                let functions_base = self.definitions.function_tys.len();
                 for name in ast.structure_names {
                     register_structure_name(
                         name,
@@ -152,46 +540,50 @@ impl Reader {
                 let mut global_scope = Vec::new();
                 let global_ty_parameters = HashMap::new();
                 let mut global_statements = Ok(Vec::new());
+                let mut function_definitions = Vec::new();
                 for statement in ast.top_level_statements {
                     match statement {
                         ast::TopLevelStatement::StructureDefinition(structure_definition) => {
-                            let (kind, definition) = translate_structure_definition(
-                                structure_definition,
-                                &mut named_items,
-                                &self.exported_items,
-                                &file,
-                                &mut self.num_errors,
+                            let (kind, definition) = crate::stats::time(
+                                crate::stats::Phase::TranslateStructureDefinitions,
+                                || {
+                                    translate_structure_definition(
+                                        structure_definition,
+                                        &terms,
+                                        &mut named_items,
+                                        &self.exported_items,
+                                        &file,
+                                        &mut self.num_errors,
+                                    )
+                                },
                             );
-                            let new_index = self.definitions.structures.len();
-                            self.definitions
-                                .tys_kind
-                                .insert(backend::TyConstructor::Structure(new_index), kind);
+                            self.definitions.structure_kinds.push(kind);
                             self.definitions.structures.push(definition);
                         }
                         ast::TopLevelStatement::FunctionDefinition(function_definition) => {
-                            if let Some((ty, definition)) = translate_function_definition(
-                                function_definition,
-                                &global_variables,
-                                &named_items,
-                                &self.exported_items,
-                                &file,
-                                &mut self.num_errors,
-                            ) {
-                                self.definitions.functions.push((ty, definition));
-                            }
+                            // Deferred: function bodies only read the
+                            // environment, so they are checked in parallel
+                            // once it is complete.
+                            function_definitions.push(function_definition);
                         }
                         ast::TopLevelStatement::Statement(statement) => {
-                            match translate_statement(
-                                statement,
-                                &mut global_variables,
-                                &mut num_global_variables,
-                                &mut global_scope,
-                                &global_ty_parameters,
-                                None,
-                                &named_items,
-                                &self.exported_items,
-                                &file,
-                                &mut self.num_errors,
+                            match crate::stats::time(
+                                crate::stats::Phase::TranslateStatements,
+                                || {
+                                    translate_statement(
+                                        statement,
+                                        &terms,
+                                        &mut global_variables,
+                                        &mut num_global_variables,
+                                        &mut global_scope,
+                                        &global_ty_parameters,
+                                        None,
+                                        &named_items,
+                                        &self.exported_items,
+                                        &file,
+                                        &mut self.num_errors,
+                                    )
+                                },
                             ) {
                                 Some(stmt) => {
                                     if let Some(stmt) = stmt {
@@ -205,22 +597,118 @@ impl Reader {
                         }
                     }
                 }
+                let translated_functions =
+                    crate::stats::time(crate::stats::Phase::TranslateFunctionDefinitions, || {
+                        translate_function_definitions(
+                            function_definitions,
+                            &terms,
+                            &global_variables,
+                            &named_items,
+                            &self.exported_items,
+                            &file,
+                            &mut self.num_errors,
+                        )
+                    });
+                for (ty, definition) in translated_functions.into_iter().flatten() {
+                    self.definitions.push_function(ty, definition);
+                }
                 for (name, index) in global_variables {
                     named_items.insert(name, Item::GlobalVariable(index));
                 }
+                let file_key = key.finish();
+                if self.num_errors == 0 {
+                    // Only clean translations are recorded: an error leaves
+                    // no usable output to replay, and the `files` vector is
+                    // no longer aligned with `file_indices`.
+                    let import_paths: Vec<PathBuf> = import_indices
+                        .iter()
+                        .map(|&index| self.files[index].path.clone())
+                        .collect();
+                    self.cache.record(
+                        path,
+                        content_hash,
+                        file_key,
+                        &import_paths,
+                        &named_items,
+                        &self.definitions,
+                        structures_base,
+                        functions_base,
+                        self.num_structures - structure_names_base,
+                        self.num_functions - function_names_base,
+                    );
+                }
                 self.exported_items.push(named_items);
                 self.files.push(file);
+                file_key
             }
-            Err(err) => {
-                err.eprint(&file);
-                self.num_errors += 1;
+            Err(errors) => {
+                self.num_errors += errors.len() as u32;
+                for error in errors {
+                    error.report(&file);
+                }
+                // No record is made for a file with errors, so its raw
+                // content hash is as good a key as any: dependents recorded
+                // in earlier, clean runs will fail validation against it.
+                cache::hash_bytes(file.content.as_bytes())
             }
         };
         let new_index = self.file_indices.len();
         self.file_indices.insert(path.to_path_buf(), new_index);
+        self.file_keys.push(file_key);
         Ok(new_index)
     }
 
+    /**
+     * Attempts to satisfy `path` from the cache. Reads the file, looks up a
+     * record for its content hash, reads the recorded imports, and replays
+     * the record if its validation key still matches. Returns `None` — and
+     * touches nothing beyond the imports already read — when the file must
+     * be parsed and translated normally instead.
+     */
+    fn splice_cached_file(&mut self, path: &Path) -> Option<usize> {
+        let source = Source::read(path).ok()?;
+        let content_hash = cache::hash_bytes(source.as_bytes());
+        let (expected_key, import_paths) = self.cache.header(path, content_hash)?;
+        let mut key = cache::KeyHasher::new();
+        key.write(content_hash);
+        for import_path in &import_paths {
+            if !self.import_chain.insert(import_path.clone()) {
+                // A circular import: fall back to the parse path, which
+                // reports it.
+                return None;
+            }
+            let result = self.read_file(import_path);
+            self.import_chain.remove(import_path);
+            let index = result.ok()?;
+            key.write(index as u64);
+            key.write(self.file_keys[index]);
+        }
+        key.write(self.num_structures as u64);
+        key.write(self.num_functions as u64);
+        key.write(self.definitions.structures.len() as u64);
+        key.write(self.definitions.function_tys.len() as u64);
+        let key = key.finish();
+        if key != expected_key {
+            return None;
+        }
+        let entry = self.cache.entry(path, content_hash)?;
+        for (kind, structure) in entry.structures {
+            self.definitions.structure_kinds.push(kind);
+            self.definitions.structures.push(structure);
+        }
+        for (ty, definition) in entry.functions {
+            self.definitions.push_function(ty, definition);
+        }
+        self.num_structures += entry.num_structure_names;
+        self.num_functions += entry.num_function_names;
+        self.exported_items.push(entry.named_items);
+        self.files.push(log::File::new(path.to_path_buf(), source));
+        let new_index = self.file_indices.len();
+        self.file_indices.insert(path.to_path_buf(), new_index);
+        self.file_keys.push(key);
+        Some(new_index)
+    }
+
     fn import_file(
         &mut self,
         ast::Import {
@@ -228,68 +716,93 @@ impl Reader {
             target,
             extra_tokens_pos,
         }: ast::Import,
+        terms: &ast::TermArena,
         parent_directory: &Path,
         file: &log::File,
-    ) -> Result<(String, usize), ()> {
+    ) -> Result<(Symbol, usize), ()> {
         let Some(target) = target else {
-            eprintln!("Missing import target after `import` at {keyword_import_pos}.");
-            file.quote_pos(keyword_import_pos);
+            let mut diagnostic = log::Diagnostic::new(format!(
+                "Missing import target after `import` at {}.",
+                file.display_pos(&keyword_import_pos)
+            ));
+            diagnostic.quote_pos(file, keyword_import_pos);
+            diagnostic.report(file);
             self.num_errors += 1;
             return Err(());
         };
+        let target = &terms[target];
         let (name, path) = match target.term {
             ast::Term::Identifier(name) => {
-                let path = parent_directory.join(&name);
+                let path = parent_directory.join(name.as_str());
                 (name, path)
             }
             ast::Term::FunctionCall {
                 function,
-                arguments,
+                ref arguments,
             } => {
-                let name = match function.term {
+                let name = match terms[function].term {
                     ast::Term::Identifier(name) => name,
                     _ => {
-                        eprintln!("Invalid import target at {}.", target.pos);
-                        file.quote_pos(target.pos);
+                        let mut diagnostic = log::Diagnostic::new(format!(
+                            "Invalid import target at {}.",
+                            file.display_pos(&target.pos)
+                        ));
+                        diagnostic.quote_pos(file, target.pos.clone());
+                        diagnostic.report(file);
                         self.num_errors += 1;
                         return Err(());
                     }
                 };
-                let path = match arguments.into_iter().next() {
-                    Some(ast::ListElement::NonEmpty(argument)) => match argument.term {
-                        ast::Term::StringLiteral(components) => {
+                let path = match arguments.first() {
+                    Some(&ast::ListElement::NonEmpty(argument)) => match terms[argument].term {
+                        ast::Term::StringLiteral(ref components) => {
                             let mut path = String::new();
                             for component in components {
                                 match component {
                                     ast::StringLiteralComponent::PlaceHolder { .. } => {
-                                        eprintln!("Import path must not contain a placeholder.");
-                                        file.quote_pos(argument.pos);
+                                        let mut diagnostic = log::Diagnostic::new(String::from(
+                                            "Import path must not contain a placeholder.",
+                                        ));
+                                        diagnostic.quote_pos(file, terms[argument].pos.clone());
+                                        diagnostic.report(file);
                                         self.num_errors += 1;
                                         return Err(());
                                     }
                                     ast::StringLiteralComponent::String(value) => {
-                                        path.push_str(&value);
+                                        path.push_str(value);
                                     }
                                 }
                             }
                             parent_directory.join(&path)
                         }
                         _ => {
-                            eprintln!("Invalid import target at {}.", target.pos);
-                            file.quote_pos(target.pos);
+                            let mut diagnostic = log::Diagnostic::new(format!(
+                                "Invalid import target at {}.",
+                                file.display_pos(&target.pos)
+                            ));
+                            diagnostic.quote_pos(file, target.pos.clone());
+                            diagnostic.report(file);
                             self.num_errors += 1;
                             return Err(());
                         }
                     },
-                    Some(ast::ListElement::Empty { comma_pos }) => {
-                        eprintln!("Empty argument before comma at {comma_pos}.");
-                        file.quote_pos(comma_pos);
+                    Some(&ast::ListElement::Empty { ref comma_pos }) => {
+                        let mut diagnostic = log::Diagnostic::new(format!(
+                            "Empty argument before comma at {}.",
+                            file.display_pos(&comma_pos)
+                        ));
+                        diagnostic.quote_pos(file, comma_pos.clone());
+                        diagnostic.report(file);
                         self.num_errors += 1;
                         return Err(());
                     }
                     None => {
-                        eprintln!("Missing import path at {}.", target.pos);
-                        file.quote_pos(target.pos);
+                        let mut diagnostic = log::Diagnostic::new(format!(
+                            "Missing import path at {}.",
+                            file.display_pos(&target.pos)
+                        ));
+                        diagnostic.quote_pos(file, target.pos.clone());
+                        diagnostic.report(file);
                         self.num_errors += 1;
                         return Err(());
                     }
@@ -297,15 +810,23 @@ impl Reader {
                 (name, path)
             }
             _ => {
-                eprintln!("Invalid import target at {}.", target.pos);
-                file.quote_pos(target.pos);
+                let mut diagnostic = log::Diagnostic::new(format!(
+                    "Invalid import target at {}.",
+                    file.display_pos(&target.pos)
+                ));
+                diagnostic.quote_pos(file, target.pos.clone());
+                diagnostic.report(file);
                 self.num_errors += 1;
                 return Err(());
             }
         };
         if let Some(extra_tokens_pos) = extra_tokens_pos {
-            eprintln!("Extra tokens at {}.", extra_tokens_pos);
-            file.quote_pos(extra_tokens_pos);
+            let mut diagnostic = log::Diagnostic::new(format!(
+                "Extra tokens at {}.",
+                file.display_pos(&extra_tokens_pos)
+            ));
+            diagnostic.quote_pos(file, extra_tokens_pos);
+            diagnostic.report(file);
             self.num_errors += 1;
             return Err(());
         }
@@ -313,8 +834,10 @@ impl Reader {
         let path = match path.canonicalize() {
             Ok(path) => path,
             Err(err) => {
-                eprintln!("Cannot read file `{}`. {}", path.display(), err);
-                file.quote_line(keyword_import_pos.line());
+                let mut diagnostic =
+                    log::Diagnostic::new(format!("Cannot read file `{}`. {}", path.display(), err));
+                diagnostic.quote_line_containing(file, keyword_import_pos.start);
+                diagnostic.report(file);
                 self.num_errors += 1;
                 return Err(());
             }
@@ -325,15 +848,22 @@ impl Reader {
             match result {
                 Ok(n) => Ok((name, n)),
                 Err(err) => {
-                    eprintln!("Cannot read file `{}`. {}", path.display(), err);
-                    file.quote_line(keyword_import_pos.line());
+                    let mut diagnostic = log::Diagnostic::new(format!(
+                        "Cannot read file `{}`. {}",
+                        path.display(),
+                        err
+                    ));
+                    diagnostic.quote_line_containing(file, keyword_import_pos.start);
+                    diagnostic.report(file);
                     self.num_errors += 1;
                     Err(())
                 }
             }
         } else {
-            eprintln!("Circular imports of `{}`.", path.display());
-            file.quote_line(keyword_import_pos.line());
+            let mut diagnostic =
+                log::Diagnostic::new(format!("Circular imports of `{}`.", path.display()));
+            diagnostic.quote_line_containing(file, keyword_import_pos.start);
+            diagnostic.report(file);
             self.num_errors += 1;
             Err(())
         }
@@ -347,23 +877,26 @@ fn register_structure_name(
         extra_tokens_pos,
     }: ast::StructureName,
     num_structures: &mut usize,
-    named_items: &mut HashMap<String, Item>,
+    named_items: &mut HashMap<Symbol, Item>,
     file: &log::File,
     num_errors: &mut u32,
 ) {
     let Some(name) = name else {
-        eprintln!(
+        let mut diagnostic = log::Diagnostic::new(format!(
             "Missing structure name after `struct` at {}.",
-            keyword_struct_pos
-        );
-        file.quote_pos(keyword_struct_pos);
+            file.display_pos(&keyword_struct_pos)
+        ));
+        diagnostic.quote_pos(file, keyword_struct_pos);
+        diagnostic.report(file);
         *num_errors += 1;
         return;
     };
     match named_items.entry(name) {
         std::collections::hash_map::Entry::Occupied(entry) => {
-            eprintln!("Duplicate definition of `{}`.", entry.key());
-            file.quote_line(keyword_struct_pos.line());
+            let mut diagnostic =
+                log::Diagnostic::new(format!("Duplicate definition of `{}`.", entry.key()));
+            diagnostic.quote_line_containing(file, keyword_struct_pos.start);
+            diagnostic.report(file);
             *num_errors += 1;
         }
         std::collections::hash_map::Entry::Vacant(entry) => {
@@ -374,8 +907,12 @@ fn register_structure_name(
         }
     }
     if let Some(extra_tokens_pos) = extra_tokens_pos {
-        eprintln!("Extra tokens at {}.", extra_tokens_pos);
-        file.quote_pos(extra_tokens_pos);
+        let mut diagnostic = log::Diagnostic::new(format!(
+            "Extra tokens at {}.",
+            file.display_pos(&extra_tokens_pos)
+        ));
+        diagnostic.quote_pos(file, extra_tokens_pos);
+        diagnostic.report(file);
         *num_errors += 1;
     }
 }
@@ -387,16 +924,17 @@ fn register_function_name(
         extra_tokens_pos,
     }: ast::FunctionName,
     num_functions: &mut usize,
-    named_items: &mut HashMap<String, Item>,
+    named_items: &mut HashMap<Symbol, Item>,
     file: &log::File,
     num_errors: &mut u32,
 ) {
     let Some(name) = name else {
-        eprintln!(
+        let mut diagnostic = log::Diagnostic::new(format!(
             "Missing structure name after `func` at {}.",
-            keyword_func_pos
-        );
-        file.quote_pos(keyword_func_pos);
+            file.display_pos(&keyword_func_pos)
+        ));
+        diagnostic.quote_pos(file, keyword_func_pos);
+        diagnostic.report(file);
         *num_errors += 1;
         return;
     };
@@ -405,8 +943,10 @@ fn register_function_name(
             if let Item::Function(functions) = entry.get_mut() {
                 functions.push(backend::Function::UserDefined(*num_functions));
             } else {
-                eprintln!("Duplicate definition of `{}`.", entry.key());
-                file.quote_line(keyword_func_pos.line());
+                let mut diagnostic =
+                    log::Diagnostic::new(format!("Duplicate definition of `{}`.", entry.key()));
+                diagnostic.quote_line_containing(file, keyword_func_pos.start);
+                diagnostic.report(file);
                 *num_errors += 1;
             }
         }
@@ -418,8 +958,12 @@ fn register_function_name(
     }
     *num_functions += 1;
     if let Some(extra_tokens_pos) = extra_tokens_pos {
-        eprintln!("Extra tokens at {}.", extra_tokens_pos);
-        file.quote_pos(extra_tokens_pos);
+        let mut diagnostic = log::Diagnostic::new(format!(
+            "Extra tokens at {}.",
+            file.display_pos(&extra_tokens_pos)
+        ));
+        diagnostic.quote_pos(file, extra_tokens_pos);
+        diagnostic.report(file);
         *num_errors += 1;
     }
 }
@@ -430,8 +974,9 @@ fn translate_structure_definition(
         fields,
         extra_tokens_pos,
     }: ast::StructureDefinition,
-    named_items: &HashMap<String, Item>,
-    exported_items: &Vec<HashMap<String, Item>>,
+    terms: &ast::TermArena,
+    named_items: &HashMap<Symbol, Item>,
+    exported_items: &Vec<HashMap<Symbol, Item>>,
     file: &log::File,
     num_errors: &mut u32,
 ) -> (backend::TyKind, backend::Structure) {
@@ -439,20 +984,28 @@ fn translate_structure_definition(
     let kind = if let Some(ty_parameters) = ty_parameters {
         for ty_parameter in ty_parameters {
             match ty_parameter {
-                ast::ListElement::NonEmpty(name) => match name.term {
+                ast::ListElement::NonEmpty(name) => match terms[name].term {
                     ast::Term::Identifier(name) => {
                         let new_index = ty_parameters_name.len();
                         ty_parameters_name.insert(name, new_index);
                     }
                     _ => {
-                        eprintln!("Invalid type parameter at {}.", name.pos);
-                        file.quote_pos(name.pos);
+                        let mut diagnostic = log::Diagnostic::new(format!(
+                            "Invalid type parameter at {}.",
+                            file.display_pos(&terms[name].pos)
+                        ));
+                        diagnostic.quote_pos(file, terms[name].pos.clone());
+                        diagnostic.report(file);
                         *num_errors += 1;
                     }
                 },
                 ast::ListElement::Empty { comma_pos } => {
-                    eprintln!("Empty type parameter before comma at {}.", comma_pos);
-                    file.quote_pos(comma_pos);
+                    let mut diagnostic = log::Diagnostic::new(format!(
+                        "Empty type parameter before comma at {}.",
+                        file.display_pos(&comma_pos)
+                    ));
+                    diagnostic.quote_pos(file, comma_pos);
+                    diagnostic.report(file);
                     *num_errors += 1;
                 }
             }
@@ -472,14 +1025,15 @@ fn translate_structure_definition(
         extra_tokens_pos,
     } in fields
     {
-        match field.term {
+        match terms[field].term {
             ast::Term::TypeAnnotation {
                 term_left: _,
                 colon_pos: _,
                 term_right: Some(field_ty),
             } => {
                 if let Some(ty) = translate_ty(
-                    *field_ty,
+                    field_ty,
+                    terms,
                     named_items,
                     &ty_parameters_name,
                     &exported_items,
@@ -490,19 +1044,31 @@ fn translate_structure_definition(
                 }
             }
             _ => {
-                eprintln!("Invalid structure field at {}.", field.pos);
-                file.quote_pos(field.pos);
+                let mut diagnostic = log::Diagnostic::new(format!(
+                    "Invalid structure field at {}.",
+                    file.display_pos(&terms[field].pos)
+                ));
+                diagnostic.quote_pos(file, terms[field].pos.clone());
+                diagnostic.report(file);
             }
         }
         if let Some(extra_tokens_pos) = extra_tokens_pos {
-            eprintln!("Extra tokens at {}.", extra_tokens_pos);
-            file.quote_pos(extra_tokens_pos);
+            let mut diagnostic = log::Diagnostic::new(format!(
+                "Extra tokens at {}.",
+                file.display_pos(&extra_tokens_pos)
+            ));
+            diagnostic.quote_pos(file, extra_tokens_pos);
+            diagnostic.report(file);
             *num_errors += 1;
         }
     }
     if let Some(extra_tokens_pos) = extra_tokens_pos {
-        eprintln!("Extra tokens at {}.", extra_tokens_pos);
-        file.quote_pos(extra_tokens_pos);
+        let mut diagnostic = log::Diagnostic::new(format!(
+            "Extra tokens at {}.",
+            file.display_pos(&extra_tokens_pos)
+        ));
+        diagnostic.quote_pos(file, extra_tokens_pos);
+        diagnostic.report(file);
         *num_errors += 1;
     }
     (
@@ -514,6 +1080,67 @@ fn translate_structure_definition(
     )
 }
 
+/**
+ * Translates every function definition of one file on a pool of worker
+ * threads. Bodies only read the shared environment (`named_items`,
+ * `global_variables`, `exported_items`), so they are independent of each
+ * other: workers pull definitions off a queue, count their errors locally,
+ * and the results come back in definition order so function indices line
+ * up with the ones handed out by [`register_function_name`].
+ */
+fn translate_function_definitions(
+    function_definitions: Vec<ast::FunctionDefinition>,
+    terms: &ast::TermArena,
+    global_variables: &HashMap<Symbol, usize>,
+    named_items: &HashMap<Symbol, Item>,
+    exported_items: &Vec<HashMap<Symbol, Item>>,
+    file: &log::File,
+    num_errors: &mut u32,
+) -> Vec<Option<(backend::FunctionTy, backend::FunctionDefinition)>> {
+    let num_definitions = function_definitions.len();
+    let queue = Mutex::new(function_definitions.into_iter().enumerate());
+    let results = Mutex::new(Vec::with_capacity(num_definitions));
+    let total_errors = std::sync::atomic::AtomicU32::new(0);
+    let num_workers = std::thread::available_parallelism()
+        .map_or(1, std::num::NonZero::get)
+        .min(num_definitions.max(1));
+    std::thread::scope(|scope| {
+        for _ in 0..num_workers {
+            scope.spawn(|| {
+                let mut worker_errors = 0;
+                loop {
+                    let next = queue.lock().unwrap().next();
+                    let Some((index, definition)) = next else {
+                        break;
+                    };
+                    let translated = translate_function_definition(
+                        definition,
+                        terms,
+                        global_variables,
+                        named_items,
+                        exported_items,
+                        file,
+                        &mut worker_errors,
+                    )
+                    .map(|(ty, mut definition)| {
+                        backend::fold::fold_function(&mut definition);
+                        (ty, definition)
+                    });
+                    results.lock().unwrap().push((index, translated));
+                }
+                total_errors.fetch_add(worker_errors, std::sync::atomic::Ordering::Relaxed);
+            });
+        }
+    });
+    *num_errors += total_errors.into_inner();
+    let mut results = results.into_inner().unwrap();
+    results.sort_unstable_by_key(|&(index, _)| index);
+    results
+        .into_iter()
+        .map(|(_, translated)| translated)
+        .collect()
+}
+
 fn translate_function_definition(
     ast::FunctionDefinition {
         ty_parameters,
@@ -522,9 +1149,10 @@ fn translate_function_definition(
         body,
         extra_tokens_pos,
     }: ast::FunctionDefinition,
-    global_variables: &HashMap<String, usize>,
-    named_items: &HashMap<String, Item>,
-    exported_items: &Vec<HashMap<String, Item>>,
+    terms: &ast::TermArena,
+    global_variables: &HashMap<Symbol, usize>,
+    named_items: &HashMap<Symbol, Item>,
+    exported_items: &Vec<HashMap<Symbol, Item>>,
     file: &log::File,
     num_errors: &mut u32,
 ) -> Option<(backend::FunctionTy, backend::FunctionDefinition)> {
@@ -533,17 +1161,25 @@ fn translate_function_definition(
         for (i, ty_parameter) in ty_parameters.into_iter().enumerate() {
             match ty_parameter {
                 ast::ListElement::NonEmpty(ty_parameter) => {
-                    if let ast::Term::Identifier(name) = ty_parameter.term {
+                    if let ast::Term::Identifier(name) = terms[ty_parameter].term {
                         ty_parameters_name.insert(name, i);
                     } else {
-                        eprintln!("Invalid type parameter at {}.", ty_parameter.pos);
-                        file.quote_pos(ty_parameter.pos);
+                        let mut diagnostic = log::Diagnostic::new(format!(
+                            "Invalid type parameter at {}.",
+                            file.display_pos(&terms[ty_parameter].pos)
+                        ));
+                        diagnostic.quote_pos(file, terms[ty_parameter].pos.clone());
+                        diagnostic.report(file);
                         *num_errors += 1;
                     }
                 }
                 ast::ListElement::Empty { comma_pos } => {
-                    eprintln!("Empty type parameter before comma at {}.", comma_pos);
-                    file.quote_pos(comma_pos);
+                    let mut diagnostic = log::Diagnostic::new(format!(
+                        "Empty type parameter before comma at {}.",
+                        file.display_pos(&comma_pos)
+                    ));
+                    diagnostic.quote_pos(file, comma_pos);
+                    diagnostic.report(file);
                     *num_errors += 1;
                 }
             }
@@ -556,38 +1192,42 @@ fn translate_function_definition(
     if let Some(parameters) = parameters {
         for parameter in parameters {
             match parameter {
-                ast::ListElement::NonEmpty(parameter) => match parameter.term {
+                ast::ListElement::NonEmpty(parameter) => match terms[parameter].term {
                     ast::Term::TypeAnnotation {
                         term_left: parameter_name,
-                        colon_pos,
+                        ref colon_pos,
                         term_right: parameter_ty,
                     } => {
-                        match parameter_name.term {
-                            ast::Term::Identifier(name) => {
-                                match local_variables.entry(name.clone()) {
-                                    std::collections::hash_map::Entry::Occupied(_) => {
-                                        eprintln!(
-                                            "Duplicate parameter name at {}.",
-                                            parameter_name.pos
-                                        );
-                                        file.quote_pos(parameter_name.pos);
-                                    }
-                                    std::collections::hash_map::Entry::Vacant(entry) => {
-                                        entry.insert(num_local_variables);
-                                        local_scope.push((name, None));
-                                        num_local_variables += 1;
-                                    }
+                        match terms[parameter_name].term {
+                            ast::Term::Identifier(name) => match local_variables.entry(name) {
+                                std::collections::hash_map::Entry::Occupied(_) => {
+                                    let mut diagnostic = log::Diagnostic::new(format!(
+                                        "Duplicate parameter name at {}.",
+                                        file.display_pos(&terms[parameter_name].pos)
+                                    ));
+                                    diagnostic.quote_pos(file, terms[parameter_name].pos.clone());
+                                    diagnostic.report(file);
                                 }
-                            }
+                                std::collections::hash_map::Entry::Vacant(entry) => {
+                                    entry.insert(num_local_variables);
+                                    local_scope.push((name, None));
+                                    num_local_variables += 1;
+                                }
+                            },
                             _ => {
-                                eprintln!("Invalid parameter name at {}.", parameter_name.pos);
-                                file.quote_pos(parameter_name.pos);
+                                let mut diagnostic = log::Diagnostic::new(format!(
+                                    "Invalid parameter name at {}.",
+                                    file.display_pos(&terms[parameter_name].pos)
+                                ));
+                                diagnostic.quote_pos(file, terms[parameter_name].pos.clone());
+                                diagnostic.report(file);
                                 *num_errors += 1;
                             }
                         }
                         if let Some(parameter_ty) = parameter_ty {
                             if let Some(ty) = translate_ty(
-                                *parameter_ty,
+                                parameter_ty,
+                                terms,
                                 named_items,
                                 &ty_parameters_name,
                                 &exported_items,
@@ -597,32 +1237,45 @@ fn translate_function_definition(
                                 parameters_ty.push(ty);
                             }
                         } else {
-                            eprintln!("Missing type after colon at {}.", colon_pos);
-                            file.quote_pos(colon_pos);
+                            let mut diagnostic = log::Diagnostic::new(format!(
+                                "Missing type after colon at {}.",
+                                file.display_pos(&colon_pos)
+                            ));
+                            diagnostic.quote_pos(file, colon_pos.clone());
+                            diagnostic.report(file);
                             *num_errors += 1;
                         }
                     }
                     _ => {
-                        eprintln!("Invalid parameter at {}.", parameter.pos);
-                        file.quote_pos(parameter.pos);
+                        let mut diagnostic = log::Diagnostic::new(format!(
+                            "Invalid parameter at {}.",
+                            file.display_pos(&terms[parameter].pos)
+                        ));
+                        diagnostic.quote_pos(file, terms[parameter].pos.clone());
+                        diagnostic.report(file);
                         *num_errors += 1;
                     }
                 },
                 ast::ListElement::Empty { comma_pos } => {
-                    eprintln!("Empty parameter before comma at {}.", comma_pos);
-                    file.quote_pos(comma_pos);
+                    let mut diagnostic = log::Diagnostic::new(format!(
+                        "Empty parameter before comma at {}.",
+                        file.display_pos(&comma_pos)
+                    ));
+                    diagnostic.quote_pos(file, comma_pos);
+                    diagnostic.report(file);
                     *num_errors += 1;
                 }
             }
         }
     } else {
-        eprintln!("Missing parameter list.");
+        log::Diagnostic::new(String::from("Missing parameter list.")).report(file);
         *num_errors += 1;
     }
     let return_ty = if let Some(return_ty) = return_ty {
         if let Some(return_ty) = return_ty.ty {
             match translate_ty(
                 return_ty,
+                terms,
                 named_items,
                 &ty_parameters_name,
                 &exported_items,
@@ -633,11 +1286,12 @@ fn translate_function_definition(
                 None => return None,
             }
         } else {
-            eprintln!(
+            let mut diagnostic = log::Diagnostic::new(format!(
                 "Missing return type after colon at {}.",
-                return_ty.colon_pos
-            );
-            file.quote_pos(return_ty.colon_pos);
+                file.display_pos(&return_ty.colon_pos)
+            ));
+            diagnostic.quote_pos(file, return_ty.colon_pos);
+            diagnostic.report(file);
             *num_errors += 1;
             return None;
         }
@@ -650,14 +1304,19 @@ fn translate_function_definition(
         }
     };
     if let Some(extra_tokens_pos) = extra_tokens_pos {
-        eprintln!("Extra tokens at {}.", extra_tokens_pos);
-        file.quote_pos(extra_tokens_pos);
+        let mut diagnostic = log::Diagnostic::new(format!(
+            "Extra tokens at {}.",
+            file.display_pos(&extra_tokens_pos)
+        ));
+        diagnostic.quote_pos(file, extra_tokens_pos);
+        diagnostic.report(file);
         *num_errors += 1;
     }
     let mut translated_body = Some(Vec::new());
     for statement in body {
         let translated_statement = translate_statement(
             statement,
+            terms,
             &mut local_variables,
             &mut num_local_variables,
             &mut local_scope,
@@ -693,22 +1352,24 @@ fn translate_function_definition(
 
 fn translate_statement(
     statement: ast::Statement,
-    variables: &mut HashMap<String, usize>,
+    terms: &ast::TermArena,
+    variables: &mut HashMap<Symbol, usize>,
     num_variables: &mut usize,
-    scope: &mut Vec<(String, Option<usize>)>,
-    ty_parameters: &HashMap<String, usize>,
-    global_variables: Option<&HashMap<String, usize>>,
-    named_items: &HashMap<String, Item>,
-    exported_items: &Vec<HashMap<String, Item>>,
+    scope: &mut Vec<(Symbol, Option<usize>)>,
+    ty_parameters: &HashMap<Symbol, usize>,
+    global_variables: Option<&HashMap<Symbol, usize>>,
+    named_items: &HashMap<Symbol, Item>,
+    exported_items: &Vec<HashMap<Symbol, Item>>,
     file: &log::File,
     num_errors: &mut u32,
 ) -> Option<Option<backend::Statement>> {
     match statement {
         ast::Statement::Term(term) => {
-            let term_pos = term.pos.clone();
+            let term_pos = terms[term].pos.clone();
             let expr = match global_variables {
                 Some(global_variables) => translate_expression(
                     term,
+                    terms,
                     named_items,
                     ty_parameters,
                     Some(&variables),
@@ -719,6 +1380,7 @@ fn translate_statement(
                 ),
                 None => translate_expression(
                     term,
+                    terms,
                     named_items,
                     ty_parameters,
                     None,
@@ -735,20 +1397,28 @@ fn translate_statement(
             term,
         } => {
             let Some(name) = term else {
-                eprintln!("Missing variable name after `var` at {}.", keyword_var_pos);
-                file.quote_pos(keyword_var_pos);
+                let mut diagnostic = log::Diagnostic::new(format!(
+                    "Missing variable name after `var` at {}.",
+                    file.display_pos(&keyword_var_pos)
+                ));
+                diagnostic.quote_pos(file, keyword_var_pos);
+                diagnostic.report(file);
                 return None;
             };
-            match name.term {
+            match terms[name].term {
                 ast::Term::Identifier(name) => {
-                    let prev_index = variables.insert(name.clone(), *num_variables);
+                    let prev_index = variables.insert(name, *num_variables);
                     scope.push((name, prev_index));
                     *num_variables += 1;
                     Some(None)
                 }
                 _ => {
-                    eprintln!("Expected a variable name at {}.", name.pos);
-                    file.quote_pos(name.pos);
+                    let mut diagnostic = log::Diagnostic::new(format!(
+                        "Expected a variable name at {}.",
+                        file.display_pos(&terms[name].pos)
+                    ));
+                    diagnostic.quote_pos(file, terms[name].pos.clone());
+                    diagnostic.report(file);
                     return None;
                 }
             }
@@ -759,10 +1429,11 @@ fn translate_statement(
             body,
         } => {
             let condition = if let Some(condition) = condition {
-                let condition_pos = condition.pos.clone();
+                let condition_pos = terms[condition].pos.clone();
                 match global_variables {
                     Some(global_variables) => translate_expression(
                         condition,
+                        terms,
                         named_items,
                         ty_parameters,
                         Some(&variables),
@@ -773,6 +1444,7 @@ fn translate_statement(
                     ),
                     None => translate_expression(
                         condition,
+                        terms,
                         named_items,
                         ty_parameters,
                         None,
@@ -783,8 +1455,12 @@ fn translate_statement(
                     ),
                 }
             } else {
-                eprintln!("Missing condition after `while` at {}", keyword_while_pos);
-                file.quote_pos(keyword_while_pos);
+                let mut diagnostic = log::Diagnostic::new(format!(
+                    "Missing condition after `while` at {}",
+                    file.display_pos(&keyword_while_pos)
+                ));
+                diagnostic.quote_pos(file, keyword_while_pos);
+                diagnostic.report(file);
                 None
             };
             let mut body_scope = Vec::new();
@@ -792,6 +1468,7 @@ fn translate_statement(
             for stmt in body {
                 match translate_statement(
                     stmt,
+                    terms,
                     variables,
                     num_variables,
                     &mut body_scope,
@@ -829,20 +1506,27 @@ fn translate_statement(
 }
 
 fn translate_import(
-    import: ast::TermWithPos,
-    named_items: &HashMap<String, Item>,
-    exported_items: &Vec<HashMap<String, Item>>,
+    import: ast::TermId,
+    terms: &ast::TermArena,
+    named_items: &HashMap<Symbol, Item>,
+    exported_items: &Vec<HashMap<Symbol, Item>>,
     file: &log::File,
     num_errors: &mut u32,
 ) -> Option<usize> {
-    let item = match import.term {
+    let item = match terms[import].term {
         ast::Term::Identifier(name) => match named_items.get(&name) {
             Some(item) => item,
             None => return None,
         },
         ast::Term::FieldByName { term_left, name } => {
-            let file_index =
-                translate_import(*term_left, named_items, exported_items, file, num_errors)?;
+            let file_index = translate_import(
+                term_left,
+                terms,
+                named_items,
+                exported_items,
+                file,
+                num_errors,
+            )?;
             match exported_items[file_index].get(&name) {
                 Some(item) => item,
                 None => return None,
@@ -857,14 +1541,15 @@ fn translate_import(
 }
 
 fn translate_ty(
-    ty: ast::TermWithPos,
-    named_items: &HashMap<String, Item>,
-    ty_parameters: &HashMap<String, usize>,
-    exported_items: &Vec<HashMap<String, Item>>,
+    ty: ast::TermId,
+    terms: &ast::TermArena,
+    named_items: &HashMap<Symbol, Item>,
+    ty_parameters: &HashMap<Symbol, usize>,
+    exported_items: &Vec<HashMap<Symbol, Item>>,
     file: &log::File,
     num_errors: &mut u32,
 ) -> Option<backend::TyBuilder> {
-    let item = match ty.term {
+    let item = match terms[ty].term {
         ast::Term::IntegerTy => {
             return Some(backend::TyBuilder::Constructor(
                 backend::TyConstructor::Integer,
@@ -885,8 +1570,14 @@ fn translate_ty(
             }
         }
         ast::Term::FieldByName { term_left, name } => {
-            let file_index =
-                translate_import(*term_left, named_items, exported_items, file, num_errors)?;
+            let file_index = translate_import(
+                term_left,
+                terms,
+                named_items,
+                exported_items,
+                file,
+                num_errors,
+            )?;
             match exported_items[file_index].get(&name) {
                 Some(item) => item,
                 None => return None,
@@ -894,10 +1585,11 @@ fn translate_ty(
         }
         ast::Term::TypeParameters {
             term_left,
-            parameters,
+            ref parameters,
         } => {
             let term_left = translate_ty(
-                *term_left,
+                term_left,
+                terms,
                 named_items,
                 ty_parameters,
                 exported_items,
@@ -906,17 +1598,22 @@ fn translate_ty(
             );
             let mut translated_parameters = Some(Vec::new());
             for parameter in parameters {
-                let translated_parameter = match parameter {
+                let translated_parameter = match *parameter {
                     ast::ListElement::NonEmpty(parameter) => translate_ty(
                         parameter,
+                        terms,
                         named_items,
                         ty_parameters,
                         exported_items,
                         file,
                         num_errors,
                     ),
-                    ast::ListElement::Empty { comma_pos } => {
-                        eprintln!("Empty type parameter before comma at {comma_pos}");
+                    ast::ListElement::Empty { ref comma_pos } => {
+                        log::Diagnostic::new(format!(
+                            "Empty type parameter before comma at {}",
+                            file.display_pos(&comma_pos)
+                        ))
+                        .report(file);
                         None
                     }
                 };
@@ -945,16 +1642,36 @@ fn translate_ty(
 }
 
 fn translate_expression(
-    expression: ast::TermWithPos,
-    named_items: &HashMap<String, Item>,
-    ty_parameters: &HashMap<String, usize>,
-    local_variables: Option<&HashMap<String, usize>>,
-    global_variables: &HashMap<String, usize>,
-    exported_items: &Vec<HashMap<String, Item>>,
+    expression: ast::TermId,
+    terms: &ast::TermArena,
+    named_items: &HashMap<Symbol, Item>,
+    ty_parameters: &HashMap<Symbol, usize>,
+    local_variables: Option<&HashMap<Symbol, usize>>,
+    global_variables: &HashMap<Symbol, usize>,
+    exported_items: &Vec<HashMap<Symbol, Item>>,
     file: &log::File,
     num_errors: &mut u32,
 ) -> Option<backend::Expression> {
-    let item = match expression.term {
+    let item = match terms[expression].term {
+        ast::Term::NumericLiteral(ref value) => {
+            if let Ok(value) = value.parse() {
+                return Some(backend::Expression::Integer(value));
+            }
+            match value.parse() {
+                Ok(value) => return Some(backend::Expression::Float(value)),
+                Err(err) => {
+                    let mut diagnostic = log::Diagnostic::new(format!(
+                        "Invalid numeric literal at {}. {}",
+                        file.display_pos(&terms[expression].pos),
+                        err
+                    ));
+                    diagnostic.quote_pos(file, terms[expression].pos.clone());
+                    diagnostic.report(file);
+                    *num_errors += 1;
+                    return None;
+                }
+            }
+        }
         ast::Term::Identifier(name) => {
             if let Some(local_variables) = local_variables {
                 if let Some(&index) = local_variables.get(&name) {
@@ -981,12 +1698,13 @@ fn translate_expression(
         }
         ast::Term::FunctionCall {
             function,
-            arguments,
+            ref arguments,
         } => {
-            if let ast::Term::FieldByName { term_left, name } = function.term {
-                let function_pos = term_left.pos.clone();
+            if let ast::Term::FieldByName { term_left, name } = terms[function].term {
+                let function_pos = terms[term_left].pos.clone();
                 let translated_function = translate_expression(
-                    *term_left,
+                    term_left,
+                    terms,
                     named_items,
                     ty_parameters,
                     local_variables,
@@ -997,10 +1715,11 @@ fn translate_expression(
                 );
                 let mut translated_arguments = Vec::new();
                 for argument in arguments {
-                    match argument {
+                    match *argument {
                         ast::ListElement::NonEmpty(argument) => {
                             if let Some(expression) = translate_expression(
                                 argument,
+                                terms,
                                 named_items,
                                 ty_parameters,
                                 local_variables,
@@ -1012,8 +1731,12 @@ fn translate_expression(
                                 translated_arguments.push(expression);
                             }
                         }
-                        ast::ListElement::Empty { comma_pos } => {
-                            eprintln!("Empty argument before comma at {comma_pos}");
+                        ast::ListElement::Empty { ref comma_pos } => {
+                            log::Diagnostic::new(format!(
+                                "Empty argument before comma at {}",
+                                file.display_pos(&comma_pos)
+                            ))
+                            .report(file);
                         }
                     }
                 }
@@ -1028,8 +1751,9 @@ fn translate_expression(
                     });
                     return Some(ret);
                 } else {
-                    eprintln!("Not a function");
-                    file.quote_pos(function_pos);
+                    let mut diagnostic = log::Diagnostic::new(String::from("Not a function"));
+                    diagnostic.quote_pos(file, function_pos);
+                    diagnostic.report(file);
                     return None;
                 }
             } else {
@@ -1038,11 +1762,12 @@ fn translate_expression(
         }
         ast::Term::TypeAnnotation {
             term_left,
-            colon_pos,
+            ref colon_pos,
             term_right,
         } => {
             translate_expression(
-                *term_left,
+                term_left,
+                terms,
                 named_items,
                 ty_parameters,
                 local_variables,
@@ -1053,7 +1778,8 @@ fn translate_expression(
             );
             if let Some(ty) = term_right {
                 translate_ty(
-                    *ty,
+                    ty,
+                    terms,
                     named_items,
                     ty_parameters,
                     exported_items,
@@ -1061,7 +1787,11 @@ fn translate_expression(
                     num_errors,
                 );
             } else {
-                eprintln!("Missing type after colon at {colon_pos}");
+                log::Diagnostic::new(format!(
+                    "Missing type after colon at {}",
+                    file.display_pos(&colon_pos)
+                ))
+                .report(file);
                 return None;
             }
             todo!();
@@ -1078,16 +1808,17 @@ fn translate_expression(
 }
 
 fn translate_reference(
-    expression: ast::TermWithPos,
-    named_items: &HashMap<String, Item>,
-    ty_parameters: &HashMap<String, usize>,
-    local_variables: Option<&HashMap<String, usize>>,
-    global_variables: &HashMap<String, usize>,
-    exported_items: &Vec<HashMap<String, Item>>,
+    expression: ast::TermId,
+    terms: &ast::TermArena,
+    named_items: &HashMap<Symbol, Item>,
+    ty_parameters: &HashMap<Symbol, usize>,
+    local_variables: Option<&HashMap<Symbol, usize>>,
+    global_variables: &HashMap<Symbol, usize>,
+    exported_items: &Vec<HashMap<Symbol, Item>>,
     file: &log::File,
     num_errors: &mut u32,
 ) -> Option<backend::Expression> {
-    let item = match expression.term {
+    let item = match terms[expression].term {
         ast::Term::Identifier(name) => {
             if let Some(local_variables) = local_variables {
                 if let Some(&index) = local_variables.get(&name) {
@@ -1116,16 +1847,17 @@ enum ImportOrExpression {
 }
 
 fn translate_import_or_expression(
-    expression: ast::TermWithPos,
-    named_items: &HashMap<String, Item>,
-    ty_parameters: &HashMap<String, usize>,
-    local_variables: Option<&HashMap<String, usize>>,
-    global_variables: &HashMap<String, usize>,
-    exported_items: &Vec<HashMap<String, Item>>,
+    expression: ast::TermId,
+    terms: &ast::TermArena,
+    named_items: &HashMap<Symbol, Item>,
+    ty_parameters: &HashMap<Symbol, usize>,
+    local_variables: Option<&HashMap<Symbol, usize>>,
+    global_variables: &HashMap<Symbol, usize>,
+    exported_items: &Vec<HashMap<Symbol, Item>>,
     file: &log::File,
     num_errors: &mut u32,
 ) -> Option<ImportOrExpression> {
-    let item = match expression.term {
+    let item = match terms[expression].term {
         ast::Term::Identifier(name) => {
             if let Some(local_variables) = local_variables {
                 if let Some(&index) = local_variables.get(&name) {
@@ -1165,16 +1897,17 @@ fn translate_import_or_expression(
 }
 
 fn translate_import_or_reference(
-    expression: ast::TermWithPos,
-    named_items: &HashMap<String, Item>,
-    ty_parameters: &HashMap<String, usize>,
-    local_variables: Option<&HashMap<String, usize>>,
-    global_variables: &HashMap<String, usize>,
-    exported_items: &Vec<HashMap<String, Item>>,
+    expression: ast::TermId,
+    terms: &ast::TermArena,
+    named_items: &HashMap<Symbol, Item>,
+    ty_parameters: &HashMap<Symbol, usize>,
+    local_variables: Option<&HashMap<Symbol, usize>>,
+    global_variables: &HashMap<Symbol, usize>,
+    exported_items: &Vec<HashMap<Symbol, Item>>,
     file: &log::File,
     num_errors: &mut u32,
 ) -> Option<ImportOrExpression> {
-    let item = match expression.term {
+    let item = match terms[expression].term {
         ast::Term::Identifier(name) => {
             if let Some(local_variables) = local_variables {
                 if let Some(&index) = local_variables.get(&name) {
@@ -21,6 +21,7 @@
  */
 
 mod tests;
+use super::interner::{intern, Symbol};
 use super::CharsPeekable;
 use crate::log::{Index, ParseError, Pos};
 use enum_iterator::Sequence;
@@ -45,6 +46,58 @@ pub struct File {
      * Top-level statements in the file (includes function definitions).
      */
     pub top_level_statements: Vec<TopLevelStatement>,
+    /**
+     * The arena holding every term of the file.
+     */
+    pub terms: TermArena,
+}
+
+/**
+ * An index into a [`TermArena`], identifying one [`TermWithPos`].
+ */
+#[derive(Clone, Copy, PartialEq, Eq, Debug)]
+pub struct TermId(u32);
+
+/**
+ * The arena owning all [`TermWithPos`] nodes of one file.
+ *
+ * Terms reference their children through [`TermId`]s into this single flat
+ * `Vec`, so parsing an expression performs no per-node allocation and
+ * dropping the AST frees all terms at once instead of recursing through a
+ * tree of boxes.
+ */
+pub struct TermArena {
+    terms: Vec<TermWithPos>,
+}
+
+impl TermArena {
+    pub fn new() -> TermArena {
+        TermArena { terms: Vec::new() }
+    }
+
+    /**
+     * Allocates a new term and returns its [`TermId`].
+     */
+    fn push(&mut self, term: TermWithPos) -> TermId {
+        let id = TermId(self.terms.len() as u32);
+        self.terms.push(term);
+        id
+    }
+
+    /**
+     * The number of terms allocated so far.
+     */
+    pub fn len(&self) -> usize {
+        self.terms.len()
+    }
+}
+
+impl std::ops::Index<TermId> for TermArena {
+    type Output = TermWithPos;
+
+    fn index(&self, id: TermId) -> &TermWithPos {
+        &self.terms[id.0 as usize]
+    }
 }
 
 /**
@@ -58,7 +111,7 @@ pub struct Import {
     /**
      * The target to import.
      */
-    pub target: Option<TermWithPos>,
+    pub target: Option<TermId>,
     pub extra_tokens_pos: Option<Pos>,
 }
 
@@ -67,7 +120,7 @@ pub struct Import {
  */
 pub struct StructureName {
     pub keyword_struct_pos: Pos,
-    pub name: Option<String>,
+    pub name: Option<Symbol>,
     pub extra_tokens_pos: Option<Pos>,
 }
 
@@ -76,7 +129,7 @@ pub struct StructureName {
  */
 pub struct FunctionName {
     pub keyword_func_pos: Pos,
-    pub name: Option<String>,
+    pub name: Option<Symbol>,
     pub extra_tokens_pos: Option<Pos>,
 }
 
@@ -120,7 +173,7 @@ pub struct StructureDefinition {
  * A structure field in the AST.
  */
 pub struct StructureField {
-    pub field: TermWithPos,
+    pub field: TermId,
     pub extra_tokens_pos: Option<Pos>,
 }
 
@@ -164,7 +217,7 @@ pub struct ReturnType {
     /**
      * The return type.
      */
-    pub ty: Option<TermWithPos>,
+    pub ty: Option<TermId>,
 }
 
 /**
@@ -182,12 +235,12 @@ pub enum Statement {
         /**
          * The variable name, type (optional) and initial value (optional).
          */
-        term: Option<TermWithPos>,
+        term: Option<TermId>,
     },
     /**
      * A single expression.
      */
-    Term(TermWithPos),
+    Term(TermId),
     /**
      * While loop.
      */
@@ -199,7 +252,7 @@ pub enum Statement {
         /**
          * The condition.
          */
-        condition: Option<TermWithPos>,
+        condition: Option<TermId>,
         /**
          * The body.
          */
@@ -244,82 +297,82 @@ pub enum Term {
     /**
      * An identifier.
      */
-    Identifier(String),
+    Identifier(Symbol),
     /**
      * A method name.
      */
-    MethodName(String),
+    MethodName(Symbol),
     /**
      * A term followed by `.` and field name.
      */
     FieldByName {
-        term_left: Box<TermWithPos>,
-        name: String,
+        term_left: TermId,
+        name: Symbol,
     },
     /**
      * A term followed by `.` and field number.
      */
     FieldByNumber {
-        term_left: Box<TermWithPos>,
+        term_left: TermId,
         number: String,
     },
     /**
      * A term followed by `:` and another term.
      */
     TypeAnnotation {
-        term_left: Box<TermWithPos>,
+        term_left: TermId,
         colon_pos: Pos,
-        term_right: Option<Box<TermWithPos>>,
+        term_right: Option<TermId>,
     },
     /**
      * Unary operation.
      */
     UnaryOperation {
-        operator: Box<TermWithPos>,
-        operand: Option<Box<TermWithPos>>,
+        operator: TermId,
+        operand: Option<TermId>,
     },
     /**
      * Binary operation.
      */
     BinaryOperation {
-        left_operand: Option<Box<TermWithPos>>,
-        operator: Box<TermWithPos>,
-        right_operand: Option<Box<TermWithPos>>,
+        left_operand: Option<TermId>,
+        operator: TermId,
+        right_operand: Option<TermId>,
     },
     /**
      * Assignment.
      */
     Assignment {
-        left_hand_side: Option<Box<TermWithPos>>,
-        operator: Box<TermWithPos>,
-        right_hand_side: Option<Box<TermWithPos>>,
+        left_hand_side: Option<TermId>,
+        operator: TermId,
+        right_hand_side: Option<TermId>,
     },
     Conjunction {
-        conditions: Vec<Option<TermWithPos>>,
+        conditions: Vec<Option<TermId>>,
         operators_pos: Vec<Pos>,
     },
     Disjunction {
-        conditions: Vec<Option<TermWithPos>>,
+        conditions: Vec<Option<TermId>>,
         operators_pos: Vec<Pos>,
     },
     Parenthesized {
-        inner: Box<TermWithPos>,
+        inner: TermId,
     },
     Tuple {
         elements: Vec<ListElement>,
     },
     FunctionCall {
-        function: Box<TermWithPos>,
+        function: TermId,
         arguments: Vec<ListElement>,
     },
     TypeParameters {
-        term_left: Box<TermWithPos>,
+        term_left: TermId,
         parameters: Vec<ListElement>,
     },
     ReturnType {
         arrow_pos: Pos,
-        parameters: Box<TermWithPos>,
-        return_ty: Option<Box<TermWithPos>>,
+        parameters: TermId,
+        return_ty: Option<TermId>,
     },
 }
 
@@ -331,7 +384,7 @@ pub enum StringLiteralComponent {
     String(String),
     PlaceHolder {
         format: String,
-        value: Option<TermWithPos>,
+        value: Option<TermId>,
     },
 }
 
@@ -340,49 +393,98 @@ pub enum StringLiteralComponent {
  */
 #[derive(PartialEq, Eq, Debug)]
 pub enum ListElement {
-    NonEmpty(TermWithPos),
+    NonEmpty(TermId),
     Empty { comma_pos: Pos },
 }
 
 /**
  * Parses a file.
+ *
+ * A parse error does not abort the file: the error is collected, the
+ * parser synchronizes to the next statement boundary (the next token
+ * starting a line, per the `is_on_new_line` flag [`read_token`] tracks),
+ * and parsing continues, so one pass reports every syntax error in the
+ * file. `Err` carries the collected errors in source order; lexing the
+ * token buffer happens up front, so a lexer error still aborts alone.
  */
-pub fn parse_file(chars_peekable: &mut CharsPeekable) -> Result<File, ParseError> {
-    let mut parser = Parser::new(chars_peekable)?;
+pub fn parse_file(chars_peekable: &mut CharsPeekable) -> Result<File, Vec<ParseError>> {
     let mut file = File {
         imports: Vec::new(),
         structure_names: Vec::new(),
         function_names: Vec::new(),
         top_level_statements: Vec::new(),
+        terms: TermArena::new(),
     };
+    let mut parser = match Parser::new(chars_peekable, &mut file.terms) {
+        Ok(parser) => parser,
+        Err(err) => return Err(vec![err]),
+    };
+    let mut errors = Vec::new();
     while let Some(item_start_token) = &mut parser.current.token {
-        if let Token::KeywordImport = item_start_token {
-            file.imports.push(parser.parse_import()?);
+        let result = if let Token::KeywordImport = item_start_token {
+            parser
+                .parse_import()
+                .map(|import| file.imports.push(import))
         } else if let Token::KeywordStruct = item_start_token {
-            let (name, definition) = parser.parse_structure_definition()?;
-            file.structure_names.push(name);
-            file.top_level_statements
-                .push(TopLevelStatement::StructureDefinition(definition));
+            parser
+                .parse_structure_definition()
+                .map(|(name, definition)| {
+                    file.structure_names.push(name);
+                    file.top_level_statements
+                        .push(TopLevelStatement::StructureDefinition(definition));
+                })
         } else if let Token::KeywordFunc = item_start_token {
-            let (name, definition) = parser.parse_function_definition()?;
-            file.function_names.push(name);
-            file.top_level_statements
-                .push(TopLevelStatement::FunctionDefinition(definition));
-        } else if let Some(statement) = parser.parse_statement(&mut Vec::new())? {
-            file.top_level_statements
-                .push(TopLevelStatement::Statement(statement));
+            parser
+                .parse_function_definition()
+                .map(|(name, definition)| {
+                    file.function_names.push(name);
+                    file.top_level_statements
+                        .push(TopLevelStatement::FunctionDefinition(definition));
+                })
         } else {
-            return Err(ParseError::UnexpectedToken(parser.current_pos()));
+            match parser.parse_statement(&mut Vec::new()) {
+                Ok(Some(statement)) => {
+                    file.top_level_statements
+                        .push(TopLevelStatement::Statement(statement));
+                    Ok(())
+                }
+                Ok(None) => Err(ParseError::UnexpectedToken(parser.current_pos())),
+                Err(err) => Err(err),
+            }
+        };
+        if let Err(err) = result {
+            errors.push(err);
+            parser.synchronize();
         }
     }
-    Ok(file)
+    if errors.is_empty() {
+        Ok(file)
+    } else {
+        Err(errors)
+    }
+}
+
+/**
+ * Lexes the entire input and returns the number of tokens, including the
+ * end-of-input marker. Exists for the benchmark suite, which measures raw
+ * lexer throughput without parsing.
+ */
+pub fn count_tokens(chars_peekable: &mut CharsPeekable) -> Result<usize, ParseError> {
+    let mut arena = TermArena::new();
+    Ok(lex(chars_peekable, &mut arena)?.len())
 }
 
 /**
  * The parser used in [`parse_file`].
+ *
+ * It walks a token buffer produced by [`lex`] up front, so parsing never
+ * re-enters the lexer.
  */
-struct Parser<'str, 'iter> {
-    iter: &'iter mut CharsPeekable<'str>,
+struct Parser<'arena> {
+    /**
+     * The remaining tokens, ending with the end-of-input marker.
+     */
+    tokens: std::vec::IntoIter<TokenInfo>,
     /**
      * Information on the current token.
      */
@@ -391,23 +493,98 @@ struct Parser<'str, 'iter> {
      * End index of the previous token.
      */
     prev_end: Index,
+    /**
+     * The arena all parsed terms are allocated into.
+     */
+    arena: &'arena mut TermArena,
 }
 
-impl<'str, 'iter> Parser<'str, 'iter> {
+impl<'arena> Parser<'arena> {
     /**
-     * Creates a new [`Parser`] from the given [`CharsPeekable`].
-     *
-     * It calls [`read_token`] and sets [`Self::current`] to point to the
-     * first token.
+     * Lexes the whole input with [`lex`] and creates a [`Parser`] over the
+     * resulting token buffer.
      */
-    fn new(iter: &'iter mut CharsPeekable<'str>) -> Result<Parser<'str, 'iter>, ParseError> {
+    fn new(
+        iter: &mut CharsPeekable,
+        arena: &'arena mut TermArena,
+    ) -> Result<Parser<'arena>, ParseError> {
         let start = iter.index();
-        let first_token = read_token(iter, false)?;
-        Ok(Parser {
-            iter,
+        let tokens = lex(iter, arena)?;
+        Ok(Parser::over(tokens, start, arena))
+    }
+
+    /**
+     * Creates a [`Parser`] over an already lexed token buffer, which must
+     * end with the end-of-input marker.
+     */
+    fn over(tokens: Vec<TokenInfo>, start: Index, arena: &'arena mut TermArena) -> Parser<'arena> {
+        let mut tokens = tokens.into_iter();
+        let first_token = tokens.next().unwrap();
+        Parser {
+            tokens,
             current: first_token,
             prev_end: start,
-        })
+            arena,
+        }
+    }
+}
+
+/**
+ * The batched lexer pass: reads the entire input into a contiguous token
+ * buffer by calling [`read_token`] until the end of input. The last element
+ * of the buffer is the end-of-input marker ([`TokenInfo::token`] is `None`).
+ */
+fn lex(iter: &mut CharsPeekable, arena: &mut TermArena) -> Result<Vec<TokenInfo>, ParseError> {
+    let mut tokens = Vec::new();
+    loop {
+        let info = read_token(iter, false, arena)?;
+        let done = info.token.is_none();
+        tokens.push(info);
+        if done {
+            crate::stats::count(crate::stats::Counter::TokensLexed, tokens.len() as u64);
+            return Ok(tokens);
+        }
+    }
+}
+
+/**
+ * Lexes the tokens of one string literal placeholder, up to and including
+ * the closing brace matching the opening `${`, and appends the end-of-input
+ * marker so that the buffer can be handed to [`Parser::over`].
+ *
+ * # Errors
+ * - [`ParseError::UnterminatedStringLiteral`]\: EOF is reached before the
+ *   matching closing brace.
+ */
+fn lex_placeholder(
+    iter: &mut CharsPeekable,
+    start_index: Index,
+    arena: &mut TermArena,
+) -> Result<Vec<TokenInfo>, ParseError> {
+    let mut tokens = Vec::new();
+    let mut depth = 0usize;
+    loop {
+        let info = read_token(iter, false, arena)?;
+        match info.token {
+            None => return Err(ParseError::UnterminatedStringLiteral { start_index }),
+            Some(Token::OpeningBrace) => depth += 1,
+            Some(Token::ClosingBrace) => {
+                if depth == 0 {
+                    let end = info.end;
+                    tokens.push(info);
+                    tokens.push(TokenInfo {
+                        token: None,
+                        start: end,
+                        end,
+                        is_on_new_line: false,
+                    });
+                    return Ok(tokens);
+                }
+                depth -= 1;
+            }
+            Some(_) => {}
+        }
+        tokens.push(info);
     }
 }
 
@@ -423,6 +600,10 @@ struct TokenInfo {
      * Start index of the token.
      */
     start: Index,
+    /**
+     * End index of the token.
+     */
+    end: Index,
     /**
      * Whether there is a line break between this token and the previous
      * one.
@@ -453,7 +634,7 @@ enum Token {
     KeywordInt,
     KeywordFloat,
     Underscore,
-    Identifier(String),
+    Identifier(Symbol),
     Plus,
     PlusEqual,
     Hyphen,
@@ -501,13 +682,13 @@ enum Token {
     ClosingBrace,
 }
 
-impl Parser<'_, '_> {
+impl Parser<'_> {
     /**
      * Parses an import statement.
      */
     fn parse_import(&mut self) -> Result<Import, ParseError> {
         let keyword_import_pos = self.current_pos();
-        self.consume_token()?;
+        self.consume_token();
 
         // The target to import should immediately follow the keyword `import`, without
         // a line break.
@@ -530,15 +711,15 @@ impl Parser<'_, '_> {
         &mut self,
     ) -> Result<(StructureName, StructureDefinition), ParseError> {
         let keyword_struct_pos = self.current_pos();
-        self.consume_token()?;
+        self.consume_token();
 
         let name = if self.current.is_on_new_line {
             None
         } else if let Some(name) = &mut self.current.token {
             match name {
                 Token::Identifier(name) => {
-                    let name = std::mem::take(name);
-                    self.consume_token()?;
+                    let name = *name;
+                    self.consume_token();
                     Some(name)
                 }
                 _ => {
@@ -556,11 +737,11 @@ impl Parser<'_, '_> {
             None
         } else if let Some(Token::OpeningBracket) = self.current.token {
             let opening_bracket_pos = self.current_pos();
-            self.consume_token()?;
+            self.consume_token();
 
             let (ty_parameters, _) = self.parse_list_elements_and_trailing_comma()?;
             match self.current.token {
-                Some(Token::ClosingBracket) => self.consume_token()?,
+                Some(Token::ClosingBracket) => self.consume_token(),
                 Some(_) => {
                     return Err(ParseError::UnexpectedTokenInBrackets {
                         unexpected_token_pos: self.current_pos(),
@@ -583,7 +764,7 @@ impl Parser<'_, '_> {
         let mut fields = Vec::new();
         loop {
             if let Some(Token::KeywordEnd) = self.current.token {
-                self.consume_token()?;
+                self.consume_token();
                 break;
             } else if let Some(field) = self.parse_factor(false)? {
                 let extra_tokens_pos = self.consume_line()?;
@@ -594,11 +775,11 @@ impl Parser<'_, '_> {
             } else if self.current.token.is_some() {
                 return Err(ParseError::UnexpectedTokenInBlock {
                     unexpected_token_pos: self.current_pos(),
-                    start_line_indices: vec![keyword_struct_pos.line()],
+                    block_start_indices: vec![keyword_struct_pos.start],
                 });
             } else {
                 return Err(ParseError::UnclosedBlock {
-                    start_line_indices: vec![keyword_struct_pos.line()],
+                    block_start_indices: vec![keyword_struct_pos.start],
                 });
             }
         }
@@ -623,7 +804,7 @@ impl Parser<'_, '_> {
         &mut self,
     ) -> Result<(FunctionName, FunctionDefinition), ParseError> {
         let keyword_func_pos = self.current_pos();
-        self.consume_token()?;
+        self.consume_token();
 
         // The function name should immediately follow `func`, without a line break.
         let name = if self.current.is_on_new_line {
@@ -631,8 +812,8 @@ impl Parser<'_, '_> {
         } else if let Some(name) = &mut self.current.token {
             match name {
                 Token::Identifier(name) => {
-                    let name = std::mem::take(name);
-                    self.consume_token()?;
+                    let name = *name;
+                    self.consume_token();
                     Some(name)
                 }
                 _ => {
@@ -651,11 +832,11 @@ impl Parser<'_, '_> {
             None
         } else if let Some(Token::OpeningBracket) = self.current.token {
             let opening_bracket_pos = self.current_pos();
-            self.consume_token()?;
+            self.consume_token();
 
             let (ty_parameters, _) = self.parse_list_elements_and_trailing_comma()?;
             match self.current.token {
-                Some(Token::ClosingBracket) => self.consume_token()?,
+                Some(Token::ClosingBracket) => self.consume_token(),
                 Some(_) => {
                     return Err(ParseError::UnexpectedTokenInBrackets {
                         unexpected_token_pos: self.current_pos(),
@@ -678,14 +859,14 @@ impl Parser<'_, '_> {
             None
         } else if let Some(Token::OpeningParenthesis) = self.current.token {
             let opening_parenthesis_pos = self.current_pos();
-            self.consume_token()?;
+            self.consume_token();
 
             let mut parameters = Vec::new();
             loop {
                 let parameter = self.parse_assign(true)?;
                 match self.current.token {
                     Some(Token::ClosingParenthesis) => {
-                        self.consume_token()?;
+                        self.consume_token();
                         if let Some(element) = parameter {
                             parameters.push(ListElement::NonEmpty(element));
                         }
@@ -693,7 +874,7 @@ impl Parser<'_, '_> {
                     }
                     Some(Token::Comma) => {
                         let comma_pos = self.current_pos();
-                        self.consume_token()?;
+                        self.consume_token();
                         if let Some(element) = parameter {
                             parameters.push(ListElement::NonEmpty(element));
                         } else {
@@ -721,7 +902,7 @@ impl Parser<'_, '_> {
         // The return type can be written after `->` or `:` (undecided).
         let return_ty = if let Some(Token::Colon) = self.current.token {
             let arrow_pos = self.current_pos();
-            self.consume_token()?;
+            self.consume_token();
             Some(ReturnType {
                 colon_pos: arrow_pos,
                 ty: self.parse_disjunction(false)?,
@@ -733,7 +914,7 @@ impl Parser<'_, '_> {
         let extra_tokens_after_signature = self.consume_line()?;
 
         // The function body follows.
-        let body = self.parse_block(&mut vec![keyword_func_pos.line()])?;
+        let body = self.parse_block(&mut vec![keyword_func_pos.start])?;
 
         let extra_tokens_after_end = self.consume_line()?;
 
@@ -766,13 +947,13 @@ impl Parser<'_, '_> {
      */
     fn parse_block(
         &mut self,
-        start_line_indices: &mut Vec<usize>,
+        block_start_indices: &mut Vec<Index>,
     ) -> Result<Vec<Statement>, ParseError> {
         let mut body = Vec::new();
         loop {
             if let Some(Token::KeywordEnd) = self.current.token {
                 let keyword_end_pos = self.current_pos();
-                self.consume_token()?;
+                self.consume_token();
                 if !self.current.is_on_new_line && self.current.token.is_some() {
                     return Err(ParseError::ExtraTokenAfterLine {
                         extra_token_pos: self.current_pos(),
@@ -780,16 +961,16 @@ impl Parser<'_, '_> {
                     });
                 }
                 return Ok(body);
-            } else if let Some(statement) = self.parse_statement(start_line_indices)? {
+            } else if let Some(statement) = self.parse_statement(block_start_indices)? {
                 body.push(statement);
             } else if self.current.token.is_some() {
                 return Err(ParseError::UnexpectedTokenInBlock {
                     unexpected_token_pos: self.current_pos(),
-                    start_line_indices: std::mem::take(start_line_indices),
+                    block_start_indices: std::mem::take(block_start_indices),
                 });
             } else {
                 return Err(ParseError::UnclosedBlock {
-                    start_line_indices: std::mem::take(start_line_indices),
+                    block_start_indices: std::mem::take(block_start_indices),
                 });
             }
         }
@@ -804,19 +985,19 @@ impl Parser<'_, '_> {
      */
     fn parse_statement(
         &mut self,
-        start_line_indices: &mut Vec<usize>,
+        block_start_indices: &mut Vec<Index>,
     ) -> Result<Option<Statement>, ParseError> {
         if let Some(Token::KeywordVar) = self.current.token {
             self.parse_variable_declaration().map(Option::Some)
         } else if let Some(Token::KeywordWhile) = self.current.token {
-            self.parse_while_statement(start_line_indices)
+            self.parse_while_statement(block_start_indices)
                 .map(Option::Some)
         } else if let Some(term) = self.parse_assign(false)? {
             // A term immediately followed by a line break can be a statement.
             if !self.current.is_on_new_line && self.current.token.is_some() {
                 return Err(ParseError::ExtraTokenAfterLine {
                     extra_token_pos: self.current_pos(),
-                    line_pos: term.pos,
+                    line_pos: self.arena[term].pos.clone(),
                 });
             }
             Ok(Some(Statement::Term(term)))
@@ -834,7 +1015,7 @@ impl Parser<'_, '_> {
      */
     fn parse_variable_declaration(&mut self) -> Result<Statement, ParseError> {
         let keyword_var_pos = self.current_pos();
-        self.consume_token()?;
+        self.consume_token();
         let term = self.parse_assign(false)?;
         if !self.current.is_on_new_line && self.current.token.is_some() {
             return Err(ParseError::ExtraTokenAfterLine {
@@ -857,10 +1038,10 @@ impl Parser<'_, '_> {
      */
     fn parse_while_statement(
         &mut self,
-        start_line_indices: &mut Vec<usize>,
+        block_start_indices: &mut Vec<Index>,
     ) -> Result<Statement, ParseError> {
         let keyword_while_pos = self.current_pos();
-        self.consume_token()?;
+        self.consume_token();
 
         // The condition should immediately follow `while`, without line break.
         let condition = if self.current.is_on_new_line {
@@ -877,9 +1058,9 @@ impl Parser<'_, '_> {
             });
         }
 
-        start_line_indices.push(keyword_while_pos.line());
-        let body = self.parse_block(start_line_indices)?;
-        start_line_indices.pop();
+        block_start_indices.push(keyword_while_pos.start);
+        let body = self.parse_block(block_start_indices)?;
+        block_start_indices.pop();
         Ok(Statement::While {
             keyword_while_pos,
             condition,
@@ -894,7 +1075,7 @@ impl Parser<'_, '_> {
         let start = self.current.start;
         let mut consumed = false;
         while self.current.token.is_some() && !self.current.is_on_new_line {
-            self.consume_token()?;
+            self.consume_token();
             consumed = true;
         }
         Ok(consumed.then(|| self.range_from(start)))
@@ -903,33 +1084,31 @@ impl Parser<'_, '_> {
     /**
      * Parses an assignment expression.
      */
-    fn parse_assign(&mut self, allow_line_break: bool) -> Result<Option<TermWithPos>, ParseError> {
+    fn parse_assign(&mut self, allow_line_break: bool) -> Result<Option<TermId>, ParseError> {
         let start = self.current.start;
         let left_hand_side = self.parse_disjunction(allow_line_break)?;
         if let Some(operator) = self.current.token.as_ref().and_then(assignment_operator) {
             let operator_pos = self.current_pos();
-            self.consume_token()?;
+            self.consume_token();
+            let operator = self.arena.push(TermWithPos {
+                term: Term::MethodName(intern(operator)),
+                pos: operator_pos,
+            });
             let right_hand_side = self.parse_assign(allow_line_break)?;
-            Ok(Some(TermWithPos {
+            Ok(Some(self.arena.push(TermWithPos {
                 pos: self.range_from(start),
                 term: Term::Assignment {
-                    operator: Box::new(TermWithPos {
-                        term: Term::MethodName(operator.to_string()),
-                        pos: operator_pos,
-                    }),
-                    left_hand_side: left_hand_side.map(Box::new),
-                    right_hand_side: right_hand_side.map(Box::new),
+                    operator,
+                    left_hand_side,
+                    right_hand_side,
                 },
-            }))
+            })))
         } else {
             Ok(left_hand_side)
         }
     }
 
-    fn parse_disjunction(
-        &mut self,
-        allow_line_break: bool,
-    ) -> Result<Option<TermWithPos>, ParseError> {
+    fn parse_disjunction(&mut self, allow_line_break: bool) -> Result<Option<TermId>, ParseError> {
         let start = self.current.start;
         let term = self.parse_conjunction(allow_line_break)?;
         if let Some(Token::DoubleBar) = self.current.token {
@@ -937,25 +1116,22 @@ impl Parser<'_, '_> {
             let mut operators_pos = Vec::new();
             while let Some(Token::DoubleBar) = self.current.token {
                 operators_pos.push(self.current_pos());
-                self.consume_token()?;
+                self.consume_token();
                 conditions.push(self.parse_conjunction(allow_line_break)?);
             }
-            Ok(Some(TermWithPos {
+            Ok(Some(self.arena.push(TermWithPos {
                 term: Term::Disjunction {
                     conditions,
                     operators_pos,
                 },
                 pos: self.range_from(start),
-            }))
+            })))
         } else {
             return Ok(term);
         }
     }
 
-    fn parse_conjunction(
-        &mut self,
-        allow_line_break: bool,
-    ) -> Result<Option<TermWithPos>, ParseError> {
+    fn parse_conjunction(&mut self, allow_line_break: bool) -> Result<Option<TermId>, ParseError> {
         let start = self.current.start;
         let term = self.parse_binary_operation(allow_line_break)?;
         if let Some(Token::DoubleAmpersand) = self.current.token {
@@ -963,16 +1139,16 @@ impl Parser<'_, '_> {
             let mut operators_pos = Vec::new();
             while let Some(Token::DoubleAmpersand) = self.current.token {
                 operators_pos.push(self.current_pos());
-                self.consume_token()?;
+                self.consume_token();
                 conditions.push(self.parse_binary_operation(allow_line_break)?);
             }
-            Ok(Some(TermWithPos {
+            Ok(Some(self.arena.push(TermWithPos {
                 term: Term::Conjunction {
                     conditions,
                     operators_pos,
                 },
                 pos: self.range_from(start),
-            }))
+            })))
         } else {
             return Ok(term);
         }
@@ -981,7 +1157,7 @@ impl Parser<'_, '_> {
     fn parse_binary_operation(
         &mut self,
         allow_line_break: bool,
-    ) -> Result<Option<TermWithPos>, ParseError> {
+    ) -> Result<Option<TermId>, ParseError> {
         self.parse_binary_operation_rec(allow_line_break, Precedence::first())
     }
 
@@ -989,7 +1165,7 @@ impl Parser<'_, '_> {
         &mut self,
         allow_line_break: bool,
         precedence: Option<Precedence>,
-    ) -> Result<Option<TermWithPos>, ParseError> {
+    ) -> Result<Option<TermId>, ParseError> {
         let Some(precedence) = precedence else {
             return self.parse_factor(allow_line_break);
         };
@@ -1002,21 +1178,21 @@ impl Parser<'_, '_> {
             };
             if let Some(operator) = infix_operator(token, precedence) {
                 let operator_pos = self.current_pos();
-                self.consume_token()?;
+                self.consume_token();
+                let operator = self.arena.push(TermWithPos {
+                    term: Term::MethodName(intern(operator)),
+                    pos: operator_pos,
+                });
                 let right_operand =
                     self.parse_binary_operation_rec(allow_line_break, precedence.next())?;
-                left_operand = Some(TermWithPos {
+                left_operand = Some(self.arena.push(TermWithPos {
                     term: Term::BinaryOperation {
-                        left_operand: left_operand.map(Box::new),
-                        operator: Box::new(TermWithPos {
-                            // TODO: remove `.to_string()`
-                            term: Term::MethodName(operator.to_string()),
-                            pos: operator_pos,
-                        }),
-                        right_operand: right_operand.map(Box::new),
+                        left_operand,
+                        operator,
+                        right_operand,
                     },
                     pos: self.range_from(start),
-                });
+                }));
             } else {
                 break;
             }
@@ -1024,7 +1200,7 @@ impl Parser<'_, '_> {
         Ok(left_operand)
     }
 
-    fn parse_factor(&mut self, allow_line_break: bool) -> Result<Option<TermWithPos>, ParseError> {
+    fn parse_factor(&mut self, allow_line_break: bool) -> Result<Option<TermId>, ParseError> {
         let start = self.current.start;
         let mut factor = match self.parse_atom(allow_line_break)? {
             Some(factor) => factor,
@@ -1033,29 +1209,28 @@ impl Parser<'_, '_> {
         while let Some(ref token) = self.current.token {
             if let Token::Dot = token {
                 let dot_pos = self.current_pos();
-                self.consume_token()?;
+                self.consume_token();
                 match self.current.token {
-                    Some(Token::Identifier(ref mut name)) => {
-                        let name = std::mem::take(name);
-                        self.consume_token()?;
-                        factor = TermWithPos {
+                    Some(Token::Identifier(name)) => {
+                        self.consume_token();
+                        factor = self.arena.push(TermWithPos {
                             term: Term::FieldByName {
-                                term_left: Box::new(factor),
+                                term_left: factor,
                                 name,
                             },
                             pos: self.range_from(start),
-                        };
+                        });
                     }
                     Some(Token::Digits(ref mut number)) => {
                         let number = std::mem::take(number);
-                        self.consume_token()?;
-                        factor = TermWithPos {
+                        self.consume_token();
+                        factor = self.arena.push(TermWithPos {
                             term: Term::FieldByNumber {
-                                term_left: Box::new(factor),
+                                term_left: factor,
                                 number,
                             },
                             pos: self.range_from(start),
-                        };
+                        });
                     }
                     Some(_) => {
                         return Err(ParseError::UnexpectedTokenAfterDot {
@@ -1067,36 +1242,36 @@ impl Parser<'_, '_> {
                 }
             } else if let Token::Colon = token {
                 let colon_pos = self.current_pos();
-                self.consume_token()?;
+                self.consume_token();
                 let opt_term_right = self.parse_factor(allow_line_break)?;
-                factor = TermWithPos {
+                factor = self.arena.push(TermWithPos {
                     term: Term::TypeAnnotation {
-                        term_left: Box::new(factor),
+                        term_left: factor,
                         colon_pos,
-                        term_right: opt_term_right.map(Box::new),
+                        term_right: opt_term_right,
                     },
                     pos: self.range_from(start),
-                };
+                });
             } else if let Token::HyphenGreater = token {
                 let arrow_pos = self.current_pos();
-                self.consume_token()?;
+                self.consume_token();
                 let opt_ret = self.parse_factor(allow_line_break)?;
-                factor = TermWithPos {
+                factor = self.arena.push(TermWithPos {
                     term: Term::ReturnType {
                         arrow_pos,
-                        parameters: Box::new(factor),
-                        return_ty: opt_ret.map(Box::new),
+                        parameters: factor,
+                        return_ty: opt_ret,
                     },
                     pos: self.range_from(start),
-                }
+                })
             } else if !allow_line_break && self.current.is_on_new_line {
                 break;
             } else if let Token::OpeningParenthesis = token {
                 let opening_parenthesis_pos = self.current_pos();
-                self.consume_token()?;
+                self.consume_token();
                 let (elements, _) = self.parse_list_elements_and_trailing_comma()?;
                 match self.current.token {
-                    Some(Token::ClosingParenthesis) => self.consume_token()?,
+                    Some(Token::ClosingParenthesis) => self.consume_token(),
                     Some(_) => {
                         return Err(ParseError::UnexpectedTokenInParentheses {
                             unexpected_token_pos: self.current_pos(),
@@ -1109,19 +1284,19 @@ impl Parser<'_, '_> {
                         })
                     }
                 }
-                factor = TermWithPos {
+                factor = self.arena.push(TermWithPos {
                     term: Term::FunctionCall {
-                        function: Box::new(factor),
+                        function: factor,
                         arguments: elements,
                     },
                     pos: self.range_from(start),
-                };
+                });
             } else if let Token::OpeningBracket = token {
                 let opening_bracket_pos = self.current_pos();
-                self.consume_token()?;
+                self.consume_token();
                 let (elements, _) = self.parse_list_elements_and_trailing_comma()?;
                 match self.current.token {
-                    Some(Token::ClosingBracket) => self.consume_token()?,
+                    Some(Token::ClosingBracket) => self.consume_token(),
                     Some(_) => {
                         return Err(ParseError::UnexpectedTokenInBrackets {
                             unexpected_token_pos: self.current_pos(),
@@ -1134,13 +1309,13 @@ impl Parser<'_, '_> {
                         });
                     }
                 }
-                factor = TermWithPos {
+                factor = self.arena.push(TermWithPos {
                     term: Term::TypeParameters {
-                        term_left: Box::new(factor),
+                        term_left: factor,
                         parameters: elements,
                     },
                     pos: self.range_from(start),
-                };
+                });
             } else {
                 break;
             }
@@ -1148,7 +1323,7 @@ impl Parser<'_, '_> {
         Ok(Some(factor))
     }
 
-    fn parse_atom(&mut self, allow_line_break: bool) -> Result<Option<TermWithPos>, ParseError> {
+    fn parse_atom(&mut self, allow_line_break: bool) -> Result<Option<TermId>, ParseError> {
         let Some(first_token) = &mut self.current.token else {
             return Ok(None);
         };
@@ -1156,40 +1331,39 @@ impl Parser<'_, '_> {
         let term = if let Token::Underscore = first_token {
             Term::Identity
         } else if let Token::Identifier(name) = first_token {
-            let name = std::mem::take(name);
-            self.consume_token()?;
+            let name = *name;
+            self.consume_token();
             Term::Identifier(name)
         } else if let Token::StringLiteral(components) = first_token {
             let components = std::mem::take(components);
-            self.consume_token()?;
+            self.consume_token();
             Term::StringLiteral(components)
         } else if let Token::Digits(value) = first_token {
             let mut value = std::mem::take(value);
-            self.consume_token()?;
+            self.consume_token();
             if self.current.start == self.prev_end {
                 if let Some(Token::Dot) = self.current.token {
                     let number_pos = self.range_from(start);
-                    self.consume_token()?;
-                    if let Some(Token::Identifier(ref mut name)) = self.current.token {
-                        let number = TermWithPos {
+                    self.consume_token();
+                    if let Some(Token::Identifier(name)) = self.current.token {
+                        let number = self.arena.push(TermWithPos {
                             term: Term::NumericLiteral(value),
                             pos: number_pos,
-                        };
-                        let name = std::mem::take(name);
-                        self.consume_token()?;
-                        return Ok(Some(TermWithPos {
+                        });
+                        self.consume_token();
+                        return Ok(Some(self.arena.push(TermWithPos {
                             term: Term::FieldByName {
-                                term_left: Box::new(number),
+                                term_left: number,
                                 name,
                             },
                             pos: self.range_from(start),
-                        }));
+                        })));
                     } else {
                         value.push('.');
                         if self.current.start == self.prev_end {
                             if let Some(Token::Digits(ref decimal_part)) = self.current.token {
                                 value.push_str(decimal_part);
-                                self.consume_token()?;
+                                self.consume_token();
                             }
                         }
                     }
@@ -1198,11 +1372,11 @@ impl Parser<'_, '_> {
             Term::NumericLiteral(value)
         } else if let Token::Dot = first_token {
             let dot_pos = self.current_pos();
-            self.consume_token()?;
+            self.consume_token();
             if self.current.start == self.prev_end {
                 if let Some(Token::Digits(ref value)) = self.current.token {
                     let value = format!(".{value}");
-                    self.consume_token()?;
+                    self.consume_token();
                     Term::NumericLiteral(value)
                 } else {
                     return Err(ParseError::UnexpectedToken(dot_pos));
@@ -1211,17 +1385,17 @@ impl Parser<'_, '_> {
                 return Err(ParseError::UnexpectedToken(dot_pos));
             }
         } else if let Token::KeywordInt = first_token {
-            self.consume_token()?;
+            self.consume_token();
             Term::IntegerTy
         } else if let Token::KeywordFloat = first_token {
-            self.consume_token()?;
+            self.consume_token();
             Term::FloatTy
         } else if let Token::OpeningParenthesis = first_token {
             let opening_parenthesis_pos = self.current_pos();
-            self.consume_token()?;
+            self.consume_token();
             let (elements, has_trailing_comma) = self.parse_list_elements_and_trailing_comma()?;
             match self.current.token {
-                Some(Token::ClosingParenthesis) => self.consume_token()?,
+                Some(Token::ClosingParenthesis) => self.consume_token(),
                 Some(_) => {
                     return Err(ParseError::UnexpectedTokenInParentheses {
                         unexpected_token_pos: self.current_pos(),
@@ -1236,9 +1410,7 @@ impl Parser<'_, '_> {
             }
             if elements.len() == 1 && !has_trailing_comma {
                 match elements.into_iter().next().unwrap() {
-                    ListElement::NonEmpty(element) => Term::Parenthesized {
-                        inner: Box::new(element),
-                    },
+                    ListElement::NonEmpty(element) => Term::Parenthesized { inner: element },
                     ListElement::Empty { .. } => unreachable!(),
                 }
             } else {
@@ -1246,22 +1418,23 @@ impl Parser<'_, '_> {
             }
         } else if let Some(operator) = prefix_operator(&first_token) {
             let operator_pos = self.current_pos();
-            self.consume_token()?;
+            self.consume_token();
             let opt_operand = self.parse_factor(allow_line_break)?;
+            let operator = self.arena.push(TermWithPos {
+                term: Term::MethodName(intern(operator)),
+                pos: operator_pos,
+            });
             Term::UnaryOperation {
-                operand: opt_operand.map(Box::new),
-                operator: Box::new(TermWithPos {
-                    term: Term::MethodName(operator.to_string()),
-                    pos: operator_pos,
-                }),
+                operand: opt_operand,
+                operator,
             }
         } else {
             return Ok(None);
         };
-        Ok(Some(TermWithPos {
+        Ok(Some(self.arena.push(TermWithPos {
             term,
             pos: self.range_from(start),
-        }))
+        })))
     }
 
     fn parse_list_elements_and_trailing_comma(
@@ -1278,7 +1451,7 @@ impl Parser<'_, '_> {
                         comma_pos: self.current_pos(),
                     })
                 }
-                self.consume_token()?;
+                self.consume_token();
             } else {
                 let has_trailing_comma = match element {
                     Some(element) => {
@@ -1361,14 +1534,14 @@ fn assignment_operator(token: &Token) -> Option<&'static str> {
     }
 }
 
-impl Parser<'_, '_> {
+impl Parser<'_> {
     /**
      * A shorthand to get the [`Pos`] of the current token.
      */
     fn current_pos(&self) -> Pos {
         Pos {
             start: self.current.start,
-            end: self.iter.index(),
+            end: self.current.end,
         }
     }
     /**
@@ -1382,13 +1555,29 @@ impl Parser<'_, '_> {
         }
     }
     /**
-     * A shorthand to call [`read_token`] and update [`Self::prev_end`] and
-     * [`Self::current`].
+     * Advances to the next token in the buffer, updating [`Self::prev_end`]
+     * and [`Self::current`]. Stays on the end-of-input marker once it is
+     * reached.
+     */
+    fn consume_token(&mut self) {
+        self.prev_end = self.current.end;
+        if let Some(next) = self.tokens.next() {
+            self.current = next;
+        }
+    }
+    /**
+     * Recovers from a parse error: skips to the next token that starts a
+     * line, where [`parse_file`] can pick up a fresh statement. Always
+     * consumes at least one token so that recovery makes progress even
+     * when the failed production consumed nothing.
      */
-    fn consume_token(&mut self) -> Result<(), ParseError> {
-        self.prev_end = self.iter.index();
-        self.current = read_token(&mut self.iter, false)?;
-        Ok(())
+    fn synchronize(&mut self) {
+        while self.current.token.is_some() {
+            self.consume_token();
+            if self.current.is_on_new_line {
+                break;
+            }
+        }
     }
 }
 
@@ -1407,12 +1596,18 @@ impl Parser<'_, '_> {
  * - [`ParseError::InvalidBlockComment`]: `is_on_new_line` is `false` when a
  *   block comment starts.
  */
-fn read_token(iter: &mut CharsPeekable, mut is_on_new_line: bool) -> Result<TokenInfo, ParseError> {
+fn read_token(
+    iter: &mut CharsPeekable,
+    mut is_on_new_line: bool,
+    arena: &mut TermArena,
+) -> Result<TokenInfo, ParseError> {
     let (start_index, first_ch) = loop {
         let Some(ch) = iter.peek() else {
+            let index = iter.index();
             return Ok(TokenInfo {
                 token: None,
-                start: iter.index(),
+                start: index,
+                end: index,
                 is_on_new_line,
             });
         };
@@ -1473,7 +1668,8 @@ fn read_token(iter: &mut CharsPeekable, mut is_on_new_line: bool) -> Result<Toke
                                 ch => format.push(ch),
                             }
                         }
-                        let mut parser = Parser::new(iter)?;
+                        let tokens = lex_placeholder(iter, start_index, arena)?;
+                        let mut parser = Parser::over(tokens, index1, arena);
                         let value = parser.parse_disjunction(true)?;
                         match parser.current.token {
                             Some(Token::ClosingBrace) => {
@@ -1549,7 +1745,7 @@ fn read_token(iter: &mut CharsPeekable, mut is_on_new_line: bool) -> Result<Toke
                 "int" => Token::KeywordInt,
                 "float" => Token::KeywordFloat,
                 "_" => Token::Underscore,
-                _ => Token::Identifier(name),
+                _ => Token::Identifier(intern(&name)),
             }
         }
         '+' => {
@@ -1562,7 +1758,7 @@ fn read_token(iter: &mut CharsPeekable, mut is_on_new_line: bool) -> Result<Toke
         '-' => {
             if iter.consume_if('-') {
                 skip_line_comment(iter);
-                return read_token(iter, true);
+                return read_token(iter, true, arena);
             } else if iter.consume_if('=') {
                 Token::HyphenEqual
             } else if iter.consume_if('>') {
@@ -1581,14 +1777,14 @@ fn read_token(iter: &mut CharsPeekable, mut is_on_new_line: bool) -> Result<Toke
         '/' => {
             if iter.consume_if('-') {
                 skip_block_comment(iter, start_index, '/', '-', '-', '/')?;
-                return read_token(iter, is_on_new_line);
+                return read_token(iter, is_on_new_line, arena);
             } else if iter.consume_if('/') {
                 if !is_on_new_line {
                     return Err(ParseError::InvalidBlockComment { start_index });
                 }
                 skip_block_comment(iter, start_index, '/', '/', '\\', '\\')?;
                 skip_line_comment(iter);
-                return read_token(iter, true);
+                return read_token(iter, true, arena);
             } else if iter.consume_if('=') {
                 Token::SlashEqual
             } else {
@@ -1687,6 +1883,7 @@ fn read_token(iter: &mut CharsPeekable, mut is_on_new_line: bool) -> Result<Toke
     Ok(TokenInfo {
         token: Some(token),
         start: start_index,
+        end: iter.index(),
         is_on_new_line,
     })
 }
@@ -21,11 +21,8 @@
 use super::*;
 
 macro_rules! index {
-    ($line:tt : $column:tt) => {
-        Index {
-            line: $line,
-            column: $column,
-        }
+    ($byte:tt) => {
+        Index { byte: $byte }
     };
 }
 
@@ -33,18 +30,19 @@ macro_rules! index {
 fn get_pos_with_space() {
     let input = " foo  bar  baz\n";
     let mut chars_peekable = CharsPeekable::new(&input);
-    let mut parser = Parser::new(&mut chars_peekable).unwrap();
+    let mut arena = TermArena::new();
+    let mut parser = Parser::new(&mut chars_peekable, &mut arena).unwrap();
 
     for (prev, start, end) in [
-        (index!(0:0), index!(0:1), index!(0:4)),
-        (index!(0:4), index!(0:6), index!(0:9)),
-        (index!(0:9), index!(0:11), index!(0:14)),
-        (index!(0:14), index!(1:0), index!(1:0)),
+        (index!(0), index!(1), index!(4)),
+        (index!(4), index!(6), index!(9)),
+        (index!(9), index!(11), index!(14)),
+        (index!(14), index!(15), index!(15)),
     ] {
         assert_eq!(parser.prev_end, prev);
         assert_eq!(parser.current.start, start);
-        assert_eq!(parser.iter.index(), end);
-        parser.consume_token().unwrap();
+        assert_eq!(parser.current.end, end);
+        parser.consume_token();
     }
 }
 
@@ -52,26 +50,27 @@ fn get_pos_with_space() {
 fn get_pos_without_space() {
     let input = "foo+bar";
     let mut chars_peekable = CharsPeekable::new(&input);
-    let mut parser = Parser::new(&mut chars_peekable).unwrap();
+    let mut arena = TermArena::new();
+    let mut parser = Parser::new(&mut chars_peekable, &mut arena).unwrap();
 
     for (prev, start, end) in [
-        (index!(0:0), index!(0:0), index!(0:3)),
-        (index!(0:3), index!(0:3), index!(0:4)),
-        (index!(0:4), index!(0:4), index!(0:7)),
-        (index!(0:7), index!(0:7), index!(0:7)),
+        (index!(0), index!(0), index!(3)),
+        (index!(3), index!(3), index!(4)),
+        (index!(4), index!(4), index!(7)),
+        (index!(7), index!(7), index!(7)),
     ] {
         assert_eq!(parser.prev_end, prev);
         assert_eq!(parser.current.start, start);
-        assert_eq!(parser.iter.index(), end);
-        parser.consume_token().unwrap();
+        assert_eq!(parser.current.end, end);
+        parser.consume_token();
     }
 }
 
 macro_rules! pos {
-    ($start_line:tt : $start_column:tt - $end_line:tt : $end_column:tt) => {
+    ($start:tt - $end:tt) => {
         Pos {
-            start: index!($start_line:$start_column),
-            end: index!($end_line:$end_column),
+            start: index!($start),
+            end: index!($end),
         }
     };
 }
@@ -113,37 +112,29 @@ fn skip_comments() {
         ]))
     {
         let mut chars_peekable = CharsPeekable::new(&input);
-        let mut parser = Parser::new(&mut chars_peekable).unwrap();
-        assert_eq!(
-            parser.current.token,
-            Some(Token::Identifier(String::from("foo")))
-        );
+        let mut arena = TermArena::new();
+        let mut parser = Parser::new(&mut chars_peekable, &mut arena).unwrap();
+        assert_eq!(parser.current.token, Some(Token::Identifier(intern("foo"))));
         let foo_pos = parser.current_pos();
-        parser.consume_token().unwrap();
-        assert_eq!(
-            parser.current.token,
-            Some(Token::Identifier(String::from("bar")))
-        );
+        parser.consume_token();
+        assert_eq!(parser.current.token, Some(Token::Identifier(intern("bar"))));
         assert_eq!(parser.current.is_on_new_line, is_on_new_line);
         let bar_pos = parser.current_pos();
-        parser.consume_token().unwrap();
+        parser.consume_token();
         assert!(parser.current.token.is_none());
-        let lines = chars_peekable.lines();
         assert_eq!(
-            &input[lines[foo_pos.start.line].start + foo_pos.start.column
-                ..lines[foo_pos.end.line].start + foo_pos.end.column],
+            &input[foo_pos.start.byte as usize..foo_pos.end.byte as usize],
             "foo"
         );
         assert_eq!(
-            &input[lines[bar_pos.start.line].start + bar_pos.start.column
-                ..lines[bar_pos.end.line].start + bar_pos.end.column],
+            &input[bar_pos.start.byte as usize..bar_pos.end.byte as usize],
             "bar"
         );
     }
     for input in ["foo//\\\\", "foo/-\n-/ //\\\\"] {
         let mut chars_peekable = CharsPeekable::new(&input);
-        let mut parser = Parser::new(&mut chars_peekable).unwrap();
-        assert!(parser.consume_token().is_err());
+        let mut arena = TermArena::new();
+        assert!(Parser::new(&mut chars_peekable, &mut arena).is_err());
     }
 }
 
@@ -151,10 +142,14 @@ fn skip_comments() {
 fn parse_numeric_literal() {
     for input in ["12", "1.2", "12.", ".12", "6.02e23", "6.02e+23", "1.6e-19"] {
         let mut chars_peekable = CharsPeekable::new(&input);
-        let mut parser = Parser::new(&mut chars_peekable).unwrap();
+        let mut arena = TermArena::new();
+        let mut parser = Parser::new(&mut chars_peekable, &mut arena).unwrap();
         let factor = parser.parse_atom(false).unwrap().unwrap();
-        assert_eq!(factor.pos, pos!(0:0-0:(input.len())));
-        assert_eq!(factor.term, Term::NumericLiteral(String::from(input)));
+        assert_eq!(parser.arena[factor].pos, pos!(0 - (input.len() as u32)));
+        assert_eq!(
+            parser.arena[factor].term,
+            Term::NumericLiteral(String::from(input))
+        );
     }
 }
 
@@ -162,31 +157,32 @@ fn parse_numeric_literal() {
 fn parse_string_literal() {
     let input = r#""foo$x{10}${ bar }baz""#;
     let mut chars_peekable = CharsPeekable::new(&input);
-    let mut parser = Parser::new(&mut chars_peekable).unwrap();
+    let mut arena = TermArena::new();
+    let mut parser = Parser::new(&mut chars_peekable, &mut arena).unwrap();
     let factor = parser.parse_atom(false).unwrap().unwrap();
-    let Term::StringLiteral(components) = factor.term else {
+    let Term::StringLiteral(ref components) = parser.arena[factor].term else {
         panic!("Not a string literal");
     };
     assert_eq!(
         components[0],
         StringLiteralComponent::String(String::from("foo"))
     );
-    match &components[1] {
-        StringLiteralComponent::String(s) => panic!("{}", s),
-        StringLiteralComponent::PlaceHolder { format, value } => {
+    match components[1] {
+        StringLiteralComponent::String(ref s) => panic!("{}", s),
+        StringLiteralComponent::PlaceHolder { ref format, value } => {
             assert_eq!(format, "x");
-            let value = value.as_ref().unwrap();
+            let value = &parser.arena[value.unwrap()];
             assert_eq!(value.term, Term::NumericLiteral(String::from("10")));
-            assert_eq!(value.pos, pos!(0:7-0:9));
+            assert_eq!(value.pos, pos!(7 - 9));
         }
     }
-    match &components[2] {
-        StringLiteralComponent::String(s) => panic!("{}", s),
-        StringLiteralComponent::PlaceHolder { format, value } => {
+    match components[2] {
+        StringLiteralComponent::String(ref s) => panic!("{}", s),
+        StringLiteralComponent::PlaceHolder { ref format, value } => {
             assert_eq!(format, "");
-            let value = value.as_ref().unwrap();
-            assert_eq!(value.term, Term::Identifier(String::from("bar")));
-            assert_eq!(value.pos, pos!(0:13-0:16));
+            let value = &parser.arena[value.unwrap()];
+            assert_eq!(value.term, Term::Identifier(intern("bar")));
+            assert_eq!(value.pos, pos!(13 - 16));
         }
     }
     assert_eq!(
@@ -199,72 +195,79 @@ fn parse_string_literal() {
 fn parse_identifier() {
     let input = "foo";
     let mut chars_peekable = CharsPeekable::new(&input);
-    let mut parser = Parser::new(&mut chars_peekable).unwrap();
+    let mut arena = TermArena::new();
+    let mut parser = Parser::new(&mut chars_peekable, &mut arena).unwrap();
     let factor = parser.parse_atom(false).unwrap().unwrap();
-    assert_eq!(factor.term, Term::Identifier(String::from("foo")));
-    assert_eq!(factor.pos, pos!(0:0-0:3));
+    assert_eq!(parser.arena[factor].term, Term::Identifier(intern("foo")));
+    assert_eq!(parser.arena[factor].pos, pos!(0 - 3));
 }
 
 #[test]
 fn parse_field() {
     let input = "10.foo.20.bar";
     let mut chars_peekable = CharsPeekable::new(&input);
-    let mut parser = Parser::new(&mut chars_peekable).unwrap();
+    let mut arena = TermArena::new();
+    let mut parser = Parser::new(&mut chars_peekable, &mut arena).unwrap();
     let term_10_foo_20_bar = parser.parse_factor(false).unwrap().unwrap();
-    assert_eq!(term_10_foo_20_bar.pos, pos!(0:0-0:13));
+    assert_eq!(parser.arena[term_10_foo_20_bar].pos, pos!(0 - 13));
     let Term::FieldByName {
         term_left: term_10_foo_20,
         name: field_bar,
-    } = term_10_foo_20_bar.term
+    } = parser.arena[term_10_foo_20_bar].term
     else {
         panic!("Not a field by name");
     };
-    assert_eq!(field_bar, "bar");
-    assert_eq!(term_10_foo_20.pos, pos!(0:0-0:9));
+    assert_eq!(field_bar, intern("bar"));
+    assert_eq!(parser.arena[term_10_foo_20].pos, pos!(0 - 9));
     let Term::FieldByNumber {
         term_left: term_10_foo,
-        number: field_20,
-    } = term_10_foo_20.term
+        number: ref field_20,
+    } = parser.arena[term_10_foo_20].term
     else {
         panic!("Not a field by number");
     };
     assert_eq!(field_20, "20");
-    assert_eq!(term_10_foo.pos, pos!(0:0-0:6));
+    assert_eq!(parser.arena[term_10_foo].pos, pos!(0 - 6));
     let Term::FieldByName {
         term_left: term_10,
         name: field_foo,
-    } = term_10_foo.term
+    } = parser.arena[term_10_foo].term
     else {
         panic!("Not a field by name");
     };
-    assert_eq!(field_foo, "foo");
-    assert_eq!(term_10.pos, pos!(0:0-0:2));
-    assert_eq!(term_10.term, Term::NumericLiteral(String::from("10")));
+    assert_eq!(field_foo, intern("foo"));
+    assert_eq!(parser.arena[term_10].pos, pos!(0 - 2));
+    assert_eq!(
+        parser.arena[term_10].term,
+        Term::NumericLiteral(String::from("10"))
+    );
 }
 
 #[test]
 fn parse_addition() {
     let input = "foo + bar";
     let mut chars_peekable = CharsPeekable::new(&input);
-    let mut parser = Parser::new(&mut chars_peekable).unwrap();
+    let mut arena = TermArena::new();
+    let mut parser = Parser::new(&mut chars_peekable, &mut arena).unwrap();
     let factor = parser.parse_binary_operation(false).unwrap().unwrap();
-    assert_eq!(factor.pos, pos!(0:0-0:9));
+    assert_eq!(parser.arena[factor].pos, pos!(0 - 9));
     let Term::BinaryOperation {
         left_operand,
         operator,
         right_operand,
-    } = factor.term
+    } = parser.arena[factor].term
     else {
         panic!("Not a binary operation");
     };
-    let left_operand = left_operand.unwrap();
-    assert_eq!(left_operand.term, Term::Identifier(String::from("foo")));
-    assert_eq!(left_operand.pos, pos!(0:0-0:3));
-    assert_eq!(operator.term, Term::MethodName(String::from("add")));
-    assert_eq!(operator.pos, pos!(0:4-0:5));
-    let right_operand = right_operand.unwrap();
-    assert_eq!(right_operand.term, Term::Identifier(String::from("bar")));
-    assert_eq!(right_operand.pos, pos!(0:6-0:9));
+    let left_operand = &parser.arena[left_operand.unwrap()];
+    assert_eq!(left_operand.term, Term::Identifier(intern("foo")));
+    assert_eq!(left_operand.pos, pos!(0 - 3));
+    let operator = &parser.arena[operator];
+    assert_eq!(operator.term, Term::MethodName(intern("add")));
+    assert_eq!(operator.pos, pos!(4 - 5));
+    let right_operand = &parser.arena[right_operand.unwrap()];
+    assert_eq!(right_operand.term, Term::Identifier(intern("bar")));
+    assert_eq!(right_operand.pos, pos!(6 - 9));
 }
 
 #[test]
@@ -275,28 +278,29 @@ fn parse_function_definition() {
     end
     ";
     let mut chars_peekable = CharsPeekable::new(&input);
-    let mut parser = Parser::new(&mut chars_peekable).unwrap();
+    let mut arena = TermArena::new();
+    let mut parser = Parser::new(&mut chars_peekable, &mut arena).unwrap();
     let (name, definition) = parser.parse_function_definition().unwrap();
-    assert_eq!(name.name, Some(String::from("foo")));
+    assert_eq!(name.name, Some(intern("foo")));
     for (parameter, expected_parameter_name) in
         definition.parameters.unwrap().iter().zip(["x", "y"])
     {
-        match parameter {
-            ListElement::Empty { comma_pos } => panic!("{comma_pos}"),
+        match *parameter {
+            ListElement::Empty { ref comma_pos } => panic!("{comma_pos:?}"),
             ListElement::NonEmpty(parameter) => {
                 let Term::TypeAnnotation {
                     term_left,
                     colon_pos: _,
                     term_right,
-                } = &parameter.term
+                } = parser.arena[parameter].term
                 else {
-                    panic!("{}", parameter.pos);
+                    panic!("{:?}", parser.arena[parameter].pos);
                 };
-                let Term::Identifier(parameter_name) = &term_left.term else {
-                    panic!("{}", term_left.pos);
+                let Term::Identifier(parameter_name) = parser.arena[term_left].term else {
+                    panic!("{:?}", parser.arena[term_left].pos);
                 };
-                assert_eq!(parameter_name, expected_parameter_name);
-                assert_eq!(Term::IntegerTy, term_right.as_ref().unwrap().term);
+                assert_eq!(parameter_name.as_str(), expected_parameter_name);
+                assert_eq!(Term::IntegerTy, parser.arena[term_right.unwrap()].term);
             }
         }
     }
@@ -0,0 +1,813 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * Defines [`Cache`], the store of compiled binary modules.
+ *
+ * Each cleanly translated source file gets a module file next to it (`.syscm`
+ * extension) holding everything [`Reader::read_file`]
+ * (super::Reader::read_file) would produce for it: the items it exports, the
+ * structures and functions it contributes to
+ * [`Definitions`](crate::backend::Definitions), and the paths of the files it
+ * imports. A module records the hash of the source contents it was compiled
+ * from, so a warm run can skip parsing and translating unchanged files and
+ * splice the module in directly. Module files are memory-mapped when read,
+ * and only decoded on a hit.
+ *
+ * Each module additionally carries a validation key folding in the keys of
+ * the imported files and the index bases (file, structure and function
+ * counts) at the time the module was made. Translation bakes global indices
+ * into the output, so a module is only replayed when every index it mentions
+ * would come out the same; anything else falls back to a normal parse, which
+ * then refreshes the module.
+ *
+ * Modules are written with a small hand-rolled little-endian codec; a
+ * malformed, truncated or stale module file is indistinguishable from a
+ * missing one.
+ */
+
+use std::collections::HashMap;
+use std::path::{Path, PathBuf};
+use std::sync::{Arc, Mutex};
+
+use super::interner::{intern, Symbol};
+use super::Item;
+use crate::backend;
+
+/**
+ * Hashes `bytes` with FNV-1a, the content hash used to key cache entries.
+ */
+pub fn hash_bytes(bytes: &[u8]) -> u64 {
+    let mut hash = FNV_OFFSET_BASIS;
+    for &byte in bytes {
+        hash = (hash ^ byte as u64).wrapping_mul(FNV_PRIME);
+    }
+    hash
+}
+
+const FNV_OFFSET_BASIS: u64 = 0xcbf29ce484222325;
+const FNV_PRIME: u64 = 0x100000001b3;
+
+/**
+ * Incrementally folds `u64` words into a validation key, using the same
+ * FNV-1a scheme as [`hash_bytes`].
+ */
+pub struct KeyHasher {
+    hash: u64,
+}
+
+impl KeyHasher {
+    pub fn new() -> KeyHasher {
+        KeyHasher {
+            hash: FNV_OFFSET_BASIS,
+        }
+    }
+    pub fn write(&mut self, value: u64) {
+        for byte in value.to_le_bytes() {
+            self.hash = (self.hash ^ byte as u64).wrapping_mul(FNV_PRIME);
+        }
+    }
+    pub fn finish(&self) -> u64 {
+        self.hash
+    }
+}
+
+/**
+ * The store of on-disk binary modules. Module files are opened lazily, the
+ * first time a source file is looked up, and kept mapped for the rest of
+ * the run.
+ */
+pub struct Cache {
+    /**
+     * Memory-mapped module files keyed by source path. `None` caches a
+     * miss (no module, or a malformed one), so each file is probed at most
+     * once per run. Behind a mutex because the workers of
+     * [`ParsePipeline`](super::ParsePipeline) share the cache.
+     */
+    modules: Mutex<HashMap<PathBuf, Option<Arc<Module>>>>,
+}
+
+/**
+ * One module file, memory-mapped.
+ */
+struct Module {
+    bytes: ModuleBytes,
+}
+
+enum ModuleBytes {
+    /**
+     * The common case: the module file is memory-mapped.
+     */
+    Mapped(memmap2::Mmap),
+    /**
+     * Fallback for module files that cannot be mapped.
+     */
+    Owned(Vec<u8>),
+}
+
+impl Module {
+    fn bytes(&self) -> &[u8] {
+        match &self.bytes {
+            ModuleBytes::Mapped(map) => map,
+            ModuleBytes::Owned(bytes) => bytes,
+        }
+    }
+}
+
+/**
+ * The path of the module file for the source file at `source_path`.
+ */
+fn module_path(source_path: &Path) -> PathBuf {
+    source_path.with_extension("syscm")
+}
+
+/**
+ * A decoded module: the translation results for one source file.
+ */
+pub struct Entry {
+    /**
+     * The items this file exports.
+     */
+    pub named_items: HashMap<Symbol, Item>,
+    /**
+     * The structures this file appends to
+     * [`Definitions::structures`](crate::backend::Definitions::structures),
+     * each with its kind.
+     */
+    pub structures: Vec<(backend::TyKind, backend::Structure)>,
+    /**
+     * The functions this file appends to the signature and body tables
+     * ([`Definitions::function_tys`](crate::backend::Definitions::function_tys)
+     * and
+     * [`Definitions::function_definitions`](crate::backend::Definitions::function_definitions)).
+     */
+    pub functions: Vec<(backend::FunctionTy, backend::FunctionDefinition)>,
+    /**
+     * How many structure names this file registers.
+     */
+    pub num_structure_names: usize,
+    /**
+     * How many function names this file registers.
+     */
+    pub num_function_names: usize,
+}
+
+const MAGIC: &[u8; 8] = b"SYSCMOD\0";
+const VERSION: u64 = 1;
+
+/**
+ * The length of the module file prefix validated by [`open_module`] and
+ * [`Cache::module`]: magic number, version, and content hash.
+ */
+const PREFIX_LEN: usize = MAGIC.len() + 8 + 8;
+
+impl Cache {
+    /**
+     * Creates an empty cache. Module files are opened on first lookup.
+     */
+    pub fn new() -> Cache {
+        Cache {
+            modules: Mutex::new(HashMap::new()),
+        }
+    }
+
+    /**
+     * Returns the module for the source file at `path`, if a well-formed
+     * module file exists and was compiled from contents hashing to
+     * `content_hash`.
+     */
+    fn module(&self, path: &Path, content_hash: u64) -> Option<Arc<Module>> {
+        let module = self
+            .modules
+            .lock()
+            .unwrap()
+            .entry(path.to_path_buf())
+            .or_insert_with(|| open_module(path))
+            .clone()?;
+        let mut decoder = Decoder {
+            bytes: &module.bytes()[MAGIC.len() + 8..PREFIX_LEN],
+        };
+        if decoder.u64()? != content_hash {
+            return None;
+        }
+        Some(module)
+    }
+
+    /**
+     * Returns the validation key and import paths of the module for the
+     * source file at `path`, without decoding the rest of it.
+     */
+    pub fn header(&self, path: &Path, content_hash: u64) -> Option<(u64, Vec<PathBuf>)> {
+        let module = self.module(path, content_hash)?;
+        let mut decoder = Decoder {
+            bytes: &module.bytes()[PREFIX_LEN..],
+        };
+        let key = decoder.u64()?;
+        let import_paths = decoder.import_paths()?;
+        Some((key, import_paths))
+    }
+
+    /**
+     * Decodes the full module for the source file at `path`.
+     */
+    pub fn entry(&self, path: &Path, content_hash: u64) -> Option<Entry> {
+        let module = self.module(path, content_hash)?;
+        let mut decoder = Decoder {
+            bytes: &module.bytes()[PREFIX_LEN..],
+        };
+        decoder.u64()?;
+        // The import paths are only consumed through [`header`](Self::header);
+        // here they are just skipped over.
+        decoder.import_paths()?;
+        let num_named_items = decoder.usize()?;
+        let mut named_items = HashMap::new();
+        for _ in 0..num_named_items {
+            let name = intern(&decoder.str()?);
+            named_items.insert(name, decoder.item()?);
+        }
+        let num_structures = decoder.usize()?;
+        let mut structures = Vec::new();
+        for _ in 0..num_structures {
+            let kind = decoder.ty_kind()?;
+            structures.push((kind, decoder.structure()?));
+        }
+        let num_functions = decoder.usize()?;
+        let mut functions = Vec::new();
+        for _ in 0..num_functions {
+            let ty = decoder.function_ty()?;
+            functions.push((ty, decoder.function_definition()?));
+        }
+        let num_structure_names = decoder.usize()?;
+        let num_function_names = decoder.usize()?;
+        Some(Entry {
+            named_items,
+            structures,
+            functions,
+            num_structure_names,
+            num_function_names,
+        })
+    }
+
+    /**
+     * Writes the module file for the source file at `path`, whose contents
+     * hash to `content_hash`. The structures and functions the file
+     * contributed are the tails of `definitions.structures` and of the
+     * function tables starting at `structures_base` and
+     * `functions_base`. Failure to write is not an error: the next run
+     * simply compiles the file again.
+     */
+    pub fn record(
+        &self,
+        path: &Path,
+        content_hash: u64,
+        key: u64,
+        import_paths: &[PathBuf],
+        named_items: &HashMap<Symbol, Item>,
+        definitions: &backend::Definitions,
+        structures_base: usize,
+        functions_base: usize,
+        num_structure_names: usize,
+        num_function_names: usize,
+    ) {
+        let mut record = Vec::new();
+        record.extend_from_slice(MAGIC);
+        write_u64(&mut record, VERSION);
+        write_u64(&mut record, content_hash);
+        write_u64(&mut record, key);
+        write_usize(&mut record, import_paths.len());
+        for path in import_paths {
+            // Paths are stored as UTF-8; a file reachable only through a
+            // non-UTF-8 path is simply never cached.
+            let Some(path) = path.to_str() else {
+                return;
+            };
+            write_str(&mut record, path);
+        }
+        write_usize(&mut record, named_items.len());
+        for (&name, item) in named_items {
+            write_str(&mut record, name.as_str());
+            write_item(&mut record, item);
+        }
+        write_usize(&mut record, definitions.structures.len() - structures_base);
+        for (index, structure) in definitions
+            .structures
+            .iter()
+            .enumerate()
+            .skip(structures_base)
+        {
+            let Some(kind) = definitions.structure_kinds.get(index) else {
+                return;
+            };
+            write_ty_kind(&mut record, kind);
+            write_structure(&mut record, structure);
+        }
+        write_usize(&mut record, definitions.function_tys.len() - functions_base);
+        for (ty, definition) in definitions.function_tys[functions_base..]
+            .iter()
+            .zip(&definitions.function_definitions[functions_base..])
+        {
+            write_function_ty(&mut record, ty);
+            write_function_definition(&mut record, definition);
+        }
+        write_usize(&mut record, num_structure_names);
+        write_usize(&mut record, num_function_names);
+        let _ = std::fs::write(module_path(path), &record);
+        self.modules.lock().unwrap().insert(
+            path.to_path_buf(),
+            Some(Arc::new(Module {
+                bytes: ModuleBytes::Owned(record),
+            })),
+        );
+    }
+}
+
+/**
+ * Opens and memory-maps the module file for the source file at
+ * `source_path`, validating its magic number and version. Any failure
+ * yields `None`.
+ */
+fn open_module(source_path: &Path) -> Option<Arc<Module>> {
+    let path = module_path(source_path);
+    let file = std::fs::File::open(&path).ok()?;
+    // SAFETY: the mapping is valid as long as no other process truncates
+    // the module file while the compiler runs; a module corrupted
+    // mid-compile decodes as garbage tags and is rejected either way.
+    let bytes = match unsafe { memmap2::Mmap::map(&file) } {
+        Ok(map) => ModuleBytes::Mapped(map),
+        Err(_) => ModuleBytes::Owned(std::fs::read(&path).ok()?),
+    };
+    let module = Module { bytes };
+    let mut decoder = Decoder {
+        bytes: module.bytes(),
+    };
+    if decoder.take(MAGIC.len())? != MAGIC {
+        return None;
+    }
+    if decoder.u64()? != VERSION {
+        return None;
+    }
+    // The content hash must be present for the prefix to be sliced off
+    // safely later.
+    decoder.u64()?;
+    Some(Arc::new(module))
+}
+
+fn write_u64(buffer: &mut Vec<u8>, value: u64) {
+    buffer.extend_from_slice(&value.to_le_bytes());
+}
+
+fn write_usize(buffer: &mut Vec<u8>, value: usize) {
+    write_u64(buffer, value as u64);
+}
+
+fn write_str(buffer: &mut Vec<u8>, value: &str) {
+    write_usize(buffer, value.len());
+    buffer.extend_from_slice(value.as_bytes());
+}
+
+fn write_item(buffer: &mut Vec<u8>, item: &Item) {
+    match item {
+        Item::Import(index) => {
+            buffer.push(0);
+            write_usize(buffer, *index);
+        }
+        Item::Ty(ty) => {
+            buffer.push(1);
+            write_ty_builder(buffer, ty);
+        }
+        Item::Function(candidates) => {
+            buffer.push(2);
+            write_usize(buffer, candidates.len());
+            for candidate in candidates {
+                write_function(buffer, candidate);
+            }
+        }
+        Item::GlobalVariable(index) => {
+            buffer.push(3);
+            write_usize(buffer, *index);
+        }
+    }
+}
+
+fn write_ty_constructor(buffer: &mut Vec<u8>, constructor: &backend::TyConstructor) {
+    match constructor {
+        backend::TyConstructor::Integer => buffer.push(0),
+        backend::TyConstructor::Float => buffer.push(1),
+        backend::TyConstructor::Reference => buffer.push(2),
+        backend::TyConstructor::Tuple => buffer.push(3),
+        backend::TyConstructor::Function => buffer.push(4),
+        backend::TyConstructor::Structure(index) => {
+            buffer.push(5);
+            write_usize(buffer, *index);
+        }
+    }
+}
+
+fn write_ty_kind(buffer: &mut Vec<u8>, kind: &backend::TyKind) {
+    match kind {
+        backend::TyKind::Ty => buffer.push(0),
+        backend::TyKind::Abstraction { parameters, ret } => {
+            buffer.push(1);
+            write_ty_list_kind(buffer, parameters);
+            write_ty_kind(buffer, ret);
+        }
+    }
+}
+
+fn write_ty_list_kind(buffer: &mut Vec<u8>, kind: &backend::TyListKind) {
+    match kind {
+        backend::TyListKind::Nil => buffer.push(0),
+        backend::TyListKind::Cons(head, tail) => {
+            buffer.push(1);
+            write_ty_kind(buffer, head);
+            write_ty_list_kind(buffer, tail);
+        }
+        backend::TyListKind::Rest => buffer.push(2),
+    }
+}
+
+fn write_ty_builder(buffer: &mut Vec<u8>, ty: &backend::TyBuilder) {
+    match ty {
+        backend::TyBuilder::Constructor(constructor) => {
+            buffer.push(0);
+            write_ty_constructor(buffer, constructor);
+        }
+        backend::TyBuilder::Parameter(index) => {
+            buffer.push(1);
+            write_usize(buffer, *index);
+        }
+        backend::TyBuilder::Application {
+            constructor,
+            arguments,
+        } => {
+            buffer.push(2);
+            write_ty_builder(buffer, constructor);
+            write_usize(buffer, arguments.len());
+            for argument in arguments {
+                write_ty_builder(buffer, argument);
+            }
+        }
+    }
+}
+
+fn write_structure(buffer: &mut Vec<u8>, structure: &backend::Structure) {
+    write_usize(buffer, structure.num_ty_parameters);
+    write_usize(buffer, structure.fields_ty.len());
+    for field_ty in &structure.fields_ty {
+        write_ty_builder(buffer, field_ty);
+    }
+}
+
+fn write_function_ty(buffer: &mut Vec<u8>, ty: &backend::FunctionTy) {
+    write_usize(buffer, ty.num_ty_parameters);
+    write_usize(buffer, ty.parameters_ty.len());
+    for parameter_ty in &ty.parameters_ty {
+        write_ty_builder(buffer, parameter_ty);
+    }
+    write_ty_builder(buffer, &ty.return_ty);
+}
+
+fn write_function_definition(buffer: &mut Vec<u8>, definition: &backend::FunctionDefinition) {
+    write_usize(buffer, definition.num_local_variables);
+    write_usize(buffer, definition.body.len());
+    for statement in &definition.body {
+        write_statement(buffer, statement);
+    }
+}
+
+fn write_statement(buffer: &mut Vec<u8>, statement: &backend::Statement) {
+    match statement {
+        backend::Statement::Empty => buffer.push(0),
+        backend::Statement::Expr(expression) => {
+            buffer.push(1);
+            write_expression(buffer, expression);
+        }
+        backend::Statement::While(condition, body) => {
+            buffer.push(2);
+            write_expression(buffer, condition);
+            write_usize(buffer, body.len());
+            for statement in body {
+                write_statement(buffer, statement);
+            }
+        }
+        backend::Statement::Let(index, expression) => {
+            buffer.push(3);
+            write_usize(buffer, *index);
+            write_expression(buffer, expression);
+        }
+    }
+}
+
+fn write_expression(buffer: &mut Vec<u8>, expression: &backend::Expression) {
+    match expression {
+        backend::Expression::Integer(value) => {
+            buffer.push(0);
+            write_u64(buffer, *value as u64);
+        }
+        backend::Expression::Float(value) => {
+            buffer.push(1);
+            write_u64(buffer, value.to_bits());
+        }
+        backend::Expression::GlobalVariable(index) => {
+            buffer.push(2);
+            write_usize(buffer, *index);
+        }
+        backend::Expression::LocalVariable(index) => {
+            buffer.push(3);
+            write_usize(buffer, *index);
+        }
+        backend::Expression::Function { candidates, calls } => {
+            buffer.push(4);
+            write_usize(buffer, candidates.len());
+            for candidate in candidates {
+                write_function(buffer, candidate);
+            }
+            write_usize(buffer, calls.len());
+            for call in calls {
+                write_usize(buffer, call.arguments.len());
+                for argument in &call.arguments {
+                    write_expression(buffer, argument);
+                }
+            }
+        }
+    }
+}
+
+fn write_function(buffer: &mut Vec<u8>, function: &backend::Function) {
+    match function {
+        backend::Function::IAdd => buffer.push(0),
+        backend::Function::Deref => buffer.push(1),
+        backend::Function::UserDefined(index) => {
+            buffer.push(2);
+            write_usize(buffer, *index);
+        }
+        backend::Function::Field {
+            structure_index,
+            field_index,
+        } => {
+            buffer.push(3);
+            write_usize(buffer, *structure_index);
+            write_usize(buffer, *field_index);
+        }
+        backend::Function::FieldRef {
+            structure_index,
+            field_index,
+        } => {
+            buffer.push(4);
+            write_usize(buffer, *structure_index);
+            write_usize(buffer, *field_index);
+        }
+        backend::Function::Assign => buffer.push(5),
+    }
+}
+
+/**
+ * The reading end of the codec. Every method returns `None` once the input
+ * runs out or a tag is unrecognized.
+ */
+struct Decoder<'bytes> {
+    bytes: &'bytes [u8],
+}
+
+impl<'bytes> Decoder<'bytes> {
+    fn take(&mut self, len: usize) -> Option<&'bytes [u8]> {
+        if len > self.bytes.len() {
+            return None;
+        }
+        let (taken, rest) = self.bytes.split_at(len);
+        self.bytes = rest;
+        Some(taken)
+    }
+
+    fn u8(&mut self) -> Option<u8> {
+        Some(self.take(1)?[0])
+    }
+
+    fn u64(&mut self) -> Option<u64> {
+        Some(u64::from_le_bytes(self.take(8)?.try_into().unwrap()))
+    }
+
+    fn usize(&mut self) -> Option<usize> {
+        self.u64()?.try_into().ok()
+    }
+
+    fn str(&mut self) -> Option<String> {
+        let len = self.usize()?;
+        let bytes = self.take(len)?;
+        String::from_utf8(bytes.to_vec()).ok()
+    }
+
+    fn import_paths(&mut self) -> Option<Vec<PathBuf>> {
+        let len = self.usize()?;
+        let mut paths = Vec::new();
+        for _ in 0..len {
+            paths.push(PathBuf::from(self.str()?));
+        }
+        Some(paths)
+    }
+
+    fn item(&mut self) -> Option<Item> {
+        match self.u8()? {
+            0 => Some(Item::Import(self.usize()?)),
+            1 => Some(Item::Ty(self.ty_builder()?)),
+            2 => {
+                let len = self.usize()?;
+                let mut candidates = Vec::new();
+                for _ in 0..len {
+                    candidates.push(self.function()?);
+                }
+                Some(Item::Function(candidates))
+            }
+            3 => Some(Item::GlobalVariable(self.usize()?)),
+            _ => None,
+        }
+    }
+
+    fn ty_constructor(&mut self) -> Option<backend::TyConstructor> {
+        match self.u8()? {
+            0 => Some(backend::TyConstructor::Integer),
+            1 => Some(backend::TyConstructor::Float),
+            2 => Some(backend::TyConstructor::Reference),
+            3 => Some(backend::TyConstructor::Tuple),
+            4 => Some(backend::TyConstructor::Function),
+            5 => Some(backend::TyConstructor::Structure(self.usize()?)),
+            _ => None,
+        }
+    }
+
+    fn ty_kind(&mut self) -> Option<backend::TyKind> {
+        match self.u8()? {
+            0 => Some(backend::TyKind::Ty),
+            1 => {
+                let parameters = self.ty_list_kind()?;
+                let ret = Box::new(self.ty_kind()?);
+                Some(backend::TyKind::Abstraction { parameters, ret })
+            }
+            _ => None,
+        }
+    }
+
+    fn ty_list_kind(&mut self) -> Option<backend::TyListKind> {
+        match self.u8()? {
+            0 => Some(backend::TyListKind::Nil),
+            1 => {
+                let head = Box::new(self.ty_kind()?);
+                let tail = Box::new(self.ty_list_kind()?);
+                Some(backend::TyListKind::Cons(head, tail))
+            }
+            2 => Some(backend::TyListKind::Rest),
+            _ => None,
+        }
+    }
+
+    fn ty_builder(&mut self) -> Option<backend::TyBuilder> {
+        match self.u8()? {
+            0 => Some(backend::TyBuilder::Constructor(self.ty_constructor()?)),
+            1 => Some(backend::TyBuilder::Parameter(self.usize()?)),
+            2 => {
+                let constructor = Box::new(self.ty_builder()?);
+                let len = self.usize()?;
+                let mut arguments = Vec::new();
+                for _ in 0..len {
+                    arguments.push(self.ty_builder()?);
+                }
+                Some(backend::TyBuilder::Application {
+                    constructor,
+                    arguments,
+                })
+            }
+            _ => None,
+        }
+    }
+
+    fn structure(&mut self) -> Option<backend::Structure> {
+        let num_ty_parameters = self.usize()?;
+        let len = self.usize()?;
+        let mut fields_ty = Vec::new();
+        for _ in 0..len {
+            fields_ty.push(self.ty_builder()?);
+        }
+        Some(backend::Structure {
+            num_ty_parameters,
+            fields_ty,
+        })
+    }
+
+    fn function_ty(&mut self) -> Option<backend::FunctionTy> {
+        let num_ty_parameters = self.usize()?;
+        let len = self.usize()?;
+        let mut parameters_ty = Vec::new();
+        for _ in 0..len {
+            parameters_ty.push(self.ty_builder()?);
+        }
+        let return_ty = self.ty_builder()?;
+        Some(backend::FunctionTy {
+            num_ty_parameters,
+            parameters_ty,
+            return_ty,
+        })
+    }
+
+    fn function_definition(&mut self) -> Option<backend::FunctionDefinition> {
+        let num_local_variables = self.usize()?;
+        let len = self.usize()?;
+        let mut body = Vec::new();
+        for _ in 0..len {
+            body.push(self.statement()?);
+        }
+        Some(backend::FunctionDefinition {
+            num_local_variables,
+            body,
+        })
+    }
+
+    fn statement(&mut self) -> Option<backend::Statement> {
+        match self.u8()? {
+            0 => Some(backend::Statement::Empty),
+            1 => Some(backend::Statement::Expr(self.expression()?)),
+            2 => {
+                let condition = self.expression()?;
+                let len = self.usize()?;
+                let mut body = Vec::new();
+                for _ in 0..len {
+                    body.push(self.statement()?);
+                }
+                Some(backend::Statement::While(condition, body))
+            }
+            3 => {
+                let index = self.usize()?;
+                Some(backend::Statement::Let(index, self.expression()?))
+            }
+            _ => None,
+        }
+    }
+
+    fn expression(&mut self) -> Option<backend::Expression> {
+        match self.u8()? {
+            0 => Some(backend::Expression::Integer(self.u64()? as i64)),
+            1 => Some(backend::Expression::Float(f64::from_bits(self.u64()?))),
+            2 => Some(backend::Expression::GlobalVariable(self.usize()?)),
+            3 => Some(backend::Expression::LocalVariable(self.usize()?)),
+            4 => {
+                let len = self.usize()?;
+                let mut candidates = Vec::new();
+                for _ in 0..len {
+                    candidates.push(self.function()?);
+                }
+                let len = self.usize()?;
+                let mut calls = Vec::new();
+                for _ in 0..len {
+                    let len = self.usize()?;
+                    let mut arguments = Vec::new();
+                    for _ in 0..len {
+                        arguments.push(self.expression()?);
+                    }
+                    calls.push(backend::Call { arguments });
+                }
+                Some(backend::Expression::Function { candidates, calls })
+            }
+            _ => None,
+        }
+    }
+
+    fn function(&mut self) -> Option<backend::Function> {
+        match self.u8()? {
+            0 => Some(backend::Function::IAdd),
+            1 => Some(backend::Function::Deref),
+            2 => Some(backend::Function::UserDefined(self.usize()?)),
+            3 => {
+                let structure_index = self.usize()?;
+                let field_index = self.usize()?;
+                Some(backend::Function::Field {
+                    structure_index,
+                    field_index,
+                })
+            }
+            4 => {
+                let structure_index = self.usize()?;
+                let field_index = self.usize()?;
+                Some(backend::Function::FieldRef {
+                    structure_index,
+                    field_index,
+                })
+            }
+            5 => Some(backend::Function::Assign),
+            _ => None,
+        }
+    }
+}
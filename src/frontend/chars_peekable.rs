@@ -22,7 +22,6 @@
  */
 
 use crate::log::Index;
-use std::ops::Range;
 use std::str::CharIndices;
 
 /**
@@ -30,11 +29,10 @@ use std::str::CharIndices;
  * string.
  *
  * The next character can be peeked using the [`peek`](Self::peek) method.
- * It also tracks the byte ranges of each line, which can be retrieved using
- * the [`lines`](Self::lines) method.
- *
- * # TODO
- * Handle `\r\n` on Windows.
+ * Positions are reported as plain byte offsets ([`index`](Self::index)):
+ * lexing is the innermost loop of the frontend, so no per-character line
+ * bookkeeping happens here. Line and column numbers are recovered lazily
+ * by [`File`](crate::log::File) when a diagnostic is printed.
  */
 pub struct CharsPeekable<'input> {
     /**
@@ -51,15 +49,6 @@ pub struct CharsPeekable<'input> {
      * the start of the input string.
      */
     current_index: usize,
-    /**
-     * The byte position of the start of the line containing the
-     * [`current_char`](Self::current_char).
-     */
-    current_line_start: usize,
-    /**
-     * The byte ranges of each line in the input string.
-     */
-    lines: Vec<Range<usize>>,
 }
 
 impl<'input> CharsPeekable<'input> {
@@ -67,14 +56,17 @@ impl<'input> CharsPeekable<'input> {
      * Creates a new [`CharsPeekable`] instance from the given input string.
      */
     pub fn new(input: &'input str) -> Self {
+        // Positions are stored as `u32` byte offsets; see [`Index`].
+        assert!(
+            u32::try_from(input.len()).is_ok(),
+            "source files larger than 4 GiB are not supported",
+        );
         let mut iter = input.char_indices();
         let first_char = iter.next().map(|(_, ch)| ch);
         Self {
             iter,
             current_char: first_char,
             current_index: 0,
-            current_line_start: 0,
-            lines: Vec::new(),
         }
     }
     /**
@@ -84,28 +76,20 @@ impl<'input> CharsPeekable<'input> {
         self.current_char
     }
     /**
-     * Returns the line and column numbers of the next character. If at EOF,
-     * it returns the index of where the next character would be,
-     * assuming the file ends with or without a newline.
+     * Returns the byte position of the next character. If at EOF, it
+     * returns the total byte length of the input string.
      */
     pub fn index(&self) -> Index {
         Index {
-            line: self.lines.len(),
-            column: self.current_index - self.current_line_start,
+            byte: self.current_index as u32,
         }
     }
     /**
      * Consumes the next character, advancing the iterator.
      */
     pub fn consume(&mut self) {
-        let next_index = self.iter.offset();
-        let next_char = self.iter.next().map(|(_, ch)| ch);
-        if self.current_char == Some('\n') {
-            self.lines.push(self.current_line_start..self.current_index);
-            self.current_line_start = next_index;
-        }
-        self.current_index = next_index;
-        self.current_char = next_char;
+        self.current_index = self.iter.offset();
+        self.current_char = self.iter.next().map(|(_, ch)| ch);
     }
     /**
      * Consumes the next character only if it matches the expected
@@ -120,20 +104,4 @@ impl<'input> CharsPeekable<'input> {
         }
         ret
     }
-    /**
-     * Returns the byte ranges of each line in the input string.
-     * For each line, the range is represented by the byte positions
-     * of the first character of the line and the newline character (`\n`)
-     * at the end. If the file ends without a newline, the end of the last
-     * range will be the EOF byte position (i.e., the total byte length of
-     * the input string).
-     *
-     * Any line and column numbers previously obtained through the
-     * [`peek`](Self::peek) method (even if at EOF) will correspond to a
-     * valid UTF-8 boundary within the ranges returned by this method.
-     */
-    pub fn lines(mut self) -> Vec<Range<usize>> {
-        self.lines.push(self.current_line_start..self.current_index);
-        self.lines
-    }
 }
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * Defines the global string interner.
+ *
+ * Identifiers are interned once by the lexer, so the AST and the name maps
+ * in [`frontend`](super) carry and compare compact [`Symbol`]s instead of
+ * hashing and allocating a `String` per occurrence.
+ */
+
+use std::collections::HashMap;
+use std::fmt::{self, Display, Formatter};
+use std::sync::{Mutex, OnceLock};
+
+/**
+ * An interned string. Two symbols are equal exactly when the strings they
+ * were interned from are equal.
+ */
+#[derive(Clone, Copy, PartialEq, Eq, Hash, Debug)]
+pub struct Symbol(u32);
+
+impl Symbol {
+    /**
+     * Returns the string this symbol was interned from.
+     */
+    pub fn as_str(self) -> &'static str {
+        interner().lock().unwrap().strings[self.0 as usize]
+    }
+}
+
+impl Display for Symbol {
+    fn fmt(&self, f: &mut Formatter) -> fmt::Result {
+        f.write_str(self.as_str())
+    }
+}
+
+/**
+ * Interns `string`, returning its [`Symbol`].
+ */
+pub fn intern(string: &str) -> Symbol {
+    let mut interner = interner().lock().unwrap();
+    if let Some(&index) = interner.symbols.get(string) {
+        return Symbol(index);
+    }
+    // Interned strings live for the rest of the process, which lets
+    // `Symbol::as_str` hand out `&'static str` without holding the lock.
+    let string: &'static str = Box::leak(string.into());
+    let index = interner.strings.len() as u32;
+    interner.strings.push(string);
+    interner.symbols.insert(string, index);
+    Symbol(index)
+}
+
+struct Interner {
+    symbols: HashMap<&'static str, u32>,
+    strings: Vec<&'static str>,
+}
+
+fn interner() -> &'static Mutex<Interner> {
+    static INTERNER: OnceLock<Mutex<Interner>> = OnceLock::new();
+    INTERNER.get_or_init(|| {
+        Mutex::new(Interner {
+            symbols: HashMap::new(),
+            strings: Vec::new(),
+        })
+    })
+}
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * The Syscraws compiler as a library.
+ *
+ * The `syscraws` binary is a thin wrapper around this crate; the split
+ * exists so that the benchmark suite under `benches/` can drive the lexer,
+ * parser and type machinery directly.
+ */
+
+pub mod backend;
+pub mod frontend;
+pub mod log;
+pub mod source;
+pub mod stats;
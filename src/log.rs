@@ -16,26 +16,289 @@
  * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
  */
 
+/*!
+ * Diagnostics: source positions, message rendering, and the sink that
+ * collects them.
+ *
+ * A [`Diagnostic`] is built up from message lines and quoted source
+ * spans, then reported into a process-wide sink shared by the parallel
+ * parse and translation workers, like the counters in
+ * [`stats`](crate::stats). Nothing is written while compiling: records
+ * are deduplicated and capped per file as they arrive, and [`flush`]
+ * renders everything in one buffered write to standard error — as the
+ * usual human format, or as one JSON object per line after
+ * [`set_format`]`(`[`Format::Json`]`)`.
+ */
+
+use std::collections::{HashMap, HashSet};
+use std::fmt::Write as _;
 use std::fmt::{self, Display, Formatter};
+use std::io::Write as _;
 use std::ops::Range;
 use std::path::{Path, PathBuf};
+use std::sync::{Mutex, OnceLock};
+
+/**
+ * How [`flush`] renders the collected diagnostics.
+ */
+#[derive(Clone, Copy)]
+pub enum Format {
+    Human,
+    Json,
+}
+
+/**
+ * The maximum number of diagnostics reported per file; the rest are
+ * counted and summarized by [`flush`]. A badly broken generated file can
+ * produce tens of thousands, and nobody reads past the first screenful.
+ */
+const MAX_DIAGNOSTICS_PER_FILE: usize = 100;
+
+/**
+ * One collected diagnostic, ready to render in either format.
+ */
+struct Record {
+    path: PathBuf,
+    /**
+     * The primary location: the first quoted span, resolved to 0-based
+     * `(line, column)` pairs.
+     */
+    location: Option<((usize, usize), (usize, usize))>,
+    /**
+     * The first message line, without the quoted source.
+     */
+    message: String,
+    /**
+     * The full human rendering: every message line and quoted span, in
+     * the order they were added.
+     */
+    rendered: String,
+}
+
+struct Sink {
+    format: Format,
+    records: Vec<Record>,
+    /**
+     * The `(path, message)` pairs already recorded. Messages embed their
+     * positions, so identical pairs are true duplicates.
+     */
+    seen: HashSet<(PathBuf, String)>,
+    num_suppressed: HashMap<PathBuf, usize>,
+    num_kept: HashMap<PathBuf, usize>,
+}
+
+fn sink() -> &'static Mutex<Sink> {
+    static SINK: OnceLock<Mutex<Sink>> = OnceLock::new();
+    SINK.get_or_init(|| {
+        Mutex::new(Sink {
+            format: Format::Human,
+            records: Vec::new(),
+            seen: HashSet::new(),
+            num_suppressed: HashMap::new(),
+            num_kept: HashMap::new(),
+        })
+    })
+}
+
+/**
+ * Chooses the output format of [`flush`] for the rest of the process.
+ */
+pub fn set_format(format: Format) {
+    sink().lock().unwrap().format = format;
+}
+
+fn report_record(record: Record) {
+    let mut sink = sink().lock().unwrap();
+    if !sink
+        .seen
+        .insert((record.path.clone(), record.message.clone()))
+    {
+        *sink.num_suppressed.entry(record.path).or_insert(0) += 1;
+        return;
+    }
+    let num_kept = sink.num_kept.entry(record.path.clone()).or_insert(0);
+    if *num_kept >= MAX_DIAGNOSTICS_PER_FILE {
+        *sink.num_suppressed.entry(record.path).or_insert(0) += 1;
+        return;
+    }
+    *num_kept += 1;
+    sink.records.push(record);
+}
+
+/**
+ * Renders every collected diagnostic in one buffered write to standard
+ * error and resets the sink. Called once, at the end of
+ * [`frontend::read_input`](crate::frontend::read_input).
+ */
+pub fn flush() {
+    let mut sink = sink().lock().unwrap();
+    let records = std::mem::take(&mut sink.records);
+    let mut num_suppressed: Vec<(PathBuf, usize)> = sink.num_suppressed.drain().collect();
+    sink.seen.clear();
+    sink.num_kept.clear();
+    let format = sink.format;
+    drop(sink);
+    num_suppressed.sort();
+    let mut output = String::new();
+    match format {
+        Format::Human => {
+            for record in &records {
+                output.push_str(&record.rendered);
+            }
+            for (path, count) in &num_suppressed {
+                writeln!(
+                    output,
+                    "{}: {} duplicate or excess diagnostics suppressed.",
+                    path.display(),
+                    count
+                )
+                .unwrap();
+            }
+        }
+        Format::Json => {
+            for record in &records {
+                output.push_str("{\"path\":");
+                push_json_string(&mut output, &record.path.to_string_lossy());
+                output.push_str(",\"message\":");
+                push_json_string(&mut output, &record.message);
+                if let Some((start, end)) = record.location {
+                    write!(
+                        output,
+                        ",\"start_line\":{},\"start_column\":{},\"end_line\":{},\"end_column\":{}",
+                        start.0 + 1,
+                        start.1 + 1,
+                        end.0 + 1,
+                        end.1 + 1,
+                    )
+                    .unwrap();
+                }
+                output.push_str("}\n");
+            }
+            for (path, count) in &num_suppressed {
+                output.push_str("{\"path\":");
+                push_json_string(&mut output, &path.to_string_lossy());
+                writeln!(output, ",\"suppressed\":{}}}", count).unwrap();
+            }
+        }
+    }
+    if !output.is_empty() {
+        std::io::stderr().lock().write_all(output.as_bytes()).ok();
+    }
+}
+
+/**
+ * Appends `value` as a JSON string literal.
+ */
+fn push_json_string(output: &mut String, value: &str) {
+    output.push('"');
+    for c in value.chars() {
+        match c {
+            '"' | '\\' => {
+                output.push('\\');
+                output.push(c);
+            }
+            '\n' => output.push_str("\\n"),
+            c if (c as u32) < 0x20 => write!(output, "\\u{:04x}", c as u32).unwrap(),
+            _ => output.push(c),
+        }
+    }
+    output.push('"');
+}
+
+/**
+ * One diagnostic under construction: a primary message, optional further
+ * note lines, and quoted source spans. Finished with [`report`]
+ * (Self::report), which hands it to the sink.
+ */
+pub struct Diagnostic {
+    message: String,
+    location: Option<((usize, usize), (usize, usize))>,
+    rendered: String,
+}
+
+impl Diagnostic {
+    pub fn new(message: String) -> Diagnostic {
+        let rendered = format!("{}\n", message);
+        Diagnostic {
+            message,
+            location: None,
+            rendered,
+        }
+    }
+    /**
+     * Appends a further message line, such as a note pointing at related
+     * source.
+     */
+    pub fn note(&mut self, message: String) {
+        self.rendered.push_str(&message);
+        self.rendered.push('\n');
+    }
+    pub fn quote_pos(&mut self, file: &File, pos: Pos) {
+        if self.location.is_none() {
+            self.location = Some((file.position(pos.start), file.position(pos.end)));
+        }
+        file.render_quote_pos(pos, &mut self.rendered);
+    }
+    pub fn quote_index(&mut self, file: &File, index: Index) {
+        if self.location.is_none() {
+            let position = file.position(index);
+            self.location = Some((position, position));
+        }
+        file.render_quote_index(index, &mut self.rendered);
+    }
+    /**
+     * Quotes the whole line containing `index`.
+     */
+    pub fn quote_line_containing(&mut self, file: &File, index: Index) {
+        if self.location.is_none() {
+            let position = file.position(index);
+            self.location = Some((position, position));
+        }
+        file.render_quote_line(file.line_number(index), &mut self.rendered);
+    }
+    pub fn report(self, file: &File) {
+        self.report_at(&file.path);
+    }
+    /**
+     * Reports a diagnostic that has no [`File`], such as an unreadable
+     * path.
+     */
+    pub fn report_at(self, path: &Path) {
+        report_record(Record {
+            path: path.to_path_buf(),
+            location: self.location,
+            message: self.message,
+            rendered: self.rendered,
+        });
+    }
+}
 
 /**
  * Called by [`frontend::read_input`](crate::frontend::read_input).
  */
 pub fn root_file_not_found(path: &Path, err: std::io::Error) {
-    eprintln!("ERROR: File `{}` not found. {}", path.display(), err);
+    Diagnostic::new(format!(
+        "ERROR: File `{}` not found. {}",
+        path.display(),
+        err
+    ))
+    .report_at(path);
 }
 
 /**
  * Called by [`frontend::read_input`](crate::frontend::read_input).
  */
 pub fn cannot_read_root_file(path: &Path, err: std::io::Error) {
-    eprintln!("ERROR: Cannot read file `{}`. {}", path.display(), err);
+    Diagnostic::new(format!(
+        "ERROR: Cannot read file `{}`. {}",
+        path.display(),
+        err
+    ))
+    .report_at(path);
 }
 
 /**
- * Prints a final message before exiting.
+ * Prints a final message before exiting. Called after [`flush`].
  */
 pub fn aborting(num_errors: u32) {
     eprintln!("Aborting due to {num_errors} previous errors.");
@@ -43,97 +306,194 @@ pub fn aborting(num_errors: u32) {
 
 pub struct File {
     pub path: PathBuf,
-    pub content: String,
-    pub lines: Vec<Range<usize>>,
+    pub content: crate::source::Source,
+    /**
+     * The byte ranges of each line. Built lazily on the first diagnostic,
+     * so files that compile cleanly never pay for the scan.
+     */
+    lines: OnceLock<Vec<Range<usize>>>,
 }
 
 impl File {
-    pub fn quote_line(&self, line: usize) {
-        eprintln!("{}", self.path.display());
-        eprintln!(
+    /**
+     * Creates a new [`File`]. The line table is not built until a
+     * diagnostic needs it.
+     */
+    pub fn new(path: PathBuf, content: crate::source::Source) -> File {
+        File {
+            path,
+            content,
+            lines: OnceLock::new(),
+        }
+    }
+    /**
+     * Returns the byte ranges of each line in the content, scanning for
+     * newlines on the first call. For each line, the range is represented
+     * by the byte positions of the first character of the line and the
+     * newline character (`\n`) at the end. If the file ends without a
+     * newline, the end of the last range will be the total byte length of
+     * the content.
+     *
+     * # TODO
+     * Handle `\r\n` on Windows.
+     */
+    fn lines(&self) -> &[Range<usize>] {
+        self.lines.get_or_init(|| {
+            let mut lines = Vec::new();
+            let mut line_start = 0;
+            for (index, byte) in self.content.bytes().enumerate() {
+                if byte == b'\n' {
+                    lines.push(line_start..index);
+                    line_start = index + 1;
+                }
+            }
+            lines.push(line_start..self.content.len());
+            lines
+        })
+    }
+    /**
+     * Returns the index of the line containing `index`. An `index`
+     * pointing at a newline character belongs to the line it terminates.
+     */
+    fn line_number(&self, index: Index) -> usize {
+        let lines = self.lines();
+        lines
+            .partition_point(|line| line.end < index.byte as usize)
+            .min(lines.len() - 1)
+    }
+    /**
+     * Resolves `index` into a line index and a column (the byte offset
+     * from the start of the line).
+     */
+    fn position(&self, index: Index) -> (usize, usize) {
+        let line = self.line_number(index);
+        (line, index.byte as usize - self.lines()[line].start)
+    }
+    /**
+     * Resolves `index` against the line table for use in messages, shown
+     * as 1-based `line:column`.
+     */
+    pub fn display_index(&self, index: Index) -> IndexDisplay {
+        let (line, column) = self.position(index);
+        IndexDisplay { line, column }
+    }
+    /**
+     * Resolves `pos` against the line table for use in messages, shown as
+     * `start-end` with 1-based line and column numbers.
+     */
+    pub fn display_pos(&self, pos: &Pos) -> PosDisplay {
+        PosDisplay {
+            start: self.position(pos.start),
+            end: self.position(pos.end),
+        }
+    }
+    fn render_quote_line(&self, line: usize, out: &mut String) {
+        writeln!(out, "{}", self.path.display()).unwrap();
+        writeln!(
+            out,
             "L{}: !-> {}",
             line + 1,
-            &self.content[self.lines[line].clone()]
-        );
-        eprintln!();
+            &self.content[self.lines()[line].clone()]
+        )
+        .unwrap();
+        writeln!(out).unwrap();
     }
-    pub fn quote_index(&self, Index { line, column }: Index) {
-        eprintln!("{}", self.path.display());
-        let start_line = &self.content[self.lines[line].clone()];
-        eprintln!(
+    fn render_quote_index(&self, index: Index, out: &mut String) {
+        let (line, column) = self.position(index);
+        writeln!(out, "{}", self.path.display()).unwrap();
+        let start_line = &self.content[self.lines()[line].clone()];
+        writeln!(
+            out,
             "L{}: {} !-> {}",
             line + 1,
             &start_line[..column],
             &start_line[column..],
-        );
-        eprintln!();
+        )
+        .unwrap();
+        writeln!(out).unwrap();
     }
-    pub fn quote_pos(&self, Pos { start, end }: Pos) {
-        eprintln!("{}", self.path.display());
-        match end.line - start.line {
+    fn render_quote_pos(&self, pos: Pos, out: &mut String) {
+        let (start_line_number, start_column) = self.position(pos.start);
+        let (end_line_number, end_column) = self.position(pos.end);
+        writeln!(out, "{}", self.path.display()).unwrap();
+        match end_line_number - start_line_number {
             0 => {
-                let line = &self.content[self.lines[start.line].clone()];
-                eprintln!(
+                let line = &self.content[self.lines()[start_line_number].clone()];
+                writeln!(
+                    out,
                     "L{}: {} !-> {} <-! {}",
-                    start.line + 1,
-                    &line[..start.column],
-                    &line[start.column..end.column],
-                    &line[end.column..],
-                );
+                    start_line_number + 1,
+                    &line[..start_column],
+                    &line[start_column..end_column],
+                    &line[end_column..],
+                )
+                .unwrap();
             }
             1 => {
-                let start_line = &self.content[self.lines[start.line].clone()];
-                let end_line = &self.content[self.lines[end.line].clone()];
-                eprintln!(
+                let start_line = &self.content[self.lines()[start_line_number].clone()];
+                let end_line = &self.content[self.lines()[end_line_number].clone()];
+                writeln!(
+                    out,
                     "L{}: {} !-> {}",
-                    start.line + 1,
-                    &start_line[..start.column],
-                    &start_line[start.column..],
-                );
-                eprintln!(
+                    start_line_number + 1,
+                    &start_line[..start_column],
+                    &start_line[start_column..],
+                )
+                .unwrap();
+                writeln!(
+                    out,
                     "L{}: {} <-! {}",
-                    end.line + 1,
-                    &end_line[..end.column],
-                    &end_line[end.column..],
-                );
+                    end_line_number + 1,
+                    &end_line[..end_column],
+                    &end_line[end_column..],
+                )
+                .unwrap();
             }
             2 => {
-                let start_line = &self.content[self.lines[start.line].clone()];
-                let mid_line = &self.content[self.lines[start.line + 1].clone()];
-                let end_line = &self.content[self.lines[end.line].clone()];
-                eprintln!(
+                let start_line = &self.content[self.lines()[start_line_number].clone()];
+                let mid_line = &self.content[self.lines()[start_line_number + 1].clone()];
+                let end_line = &self.content[self.lines()[end_line_number].clone()];
+                writeln!(
+                    out,
                     "L{}: {} !-> {}",
-                    start.line + 1,
-                    &start_line[..start.column],
-                    &start_line[start.column..],
-                );
-                eprintln!("L{}: {}", start.line + 2, mid_line);
-                eprintln!(
+                    start_line_number + 1,
+                    &start_line[..start_column],
+                    &start_line[start_column..],
+                )
+                .unwrap();
+                writeln!(out, "L{}: {}", start_line_number + 2, mid_line).unwrap();
+                writeln!(
+                    out,
                     "L{}: {} <-! {}",
-                    end.line + 1,
-                    &end_line[..end.column],
-                    &end_line[end.column..],
-                );
+                    end_line_number + 1,
+                    &end_line[..end_column],
+                    &end_line[end_column..],
+                )
+                .unwrap();
             }
             num_lines => {
-                let start_line = &self.content[self.lines[start.line].clone()];
-                let end_line = &self.content[self.lines[end.line].clone()];
-                eprintln!(
+                let start_line = &self.content[self.lines()[start_line_number].clone()];
+                let end_line = &self.content[self.lines()[end_line_number].clone()];
+                writeln!(
+                    out,
                     "L{}: {} !-> {}",
-                    start.line + 1,
-                    &start_line[..start.column],
-                    &start_line[start.column..],
-                );
-                eprintln!("({} lines)", num_lines - 1);
-                eprintln!(
+                    start_line_number + 1,
+                    &start_line[..start_column],
+                    &start_line[start_column..],
+                )
+                .unwrap();
+                writeln!(out, "({} lines)", num_lines - 1).unwrap();
+                writeln!(
+                    out,
                     "L{}: {} <-! {}",
-                    end.line + 1,
-                    &end_line[..end.column],
-                    &end_line[end.column..],
-                );
+                    end_line_number + 1,
+                    &end_line[..end_column],
+                    &end_line[end_column..],
+                )
+                .unwrap();
             }
         }
-        eprintln!();
+        writeln!(out).unwrap();
     }
 }
 
@@ -174,12 +534,12 @@ pub enum ParseError {
     },
     /// Returned by [`parse_block`](../frontend/ast/fn.parse_block.html).
     UnclosedBlock {
-        start_line_indices: Vec<usize>,
+        block_start_indices: Vec<Index>,
     },
     /// Returned by [`parse_block`](../frontend/ast/fn.parse_block.html).
     UnexpectedTokenInBlock {
         unexpected_token_pos: Pos,
-        start_line_indices: Vec<usize>,
+        block_start_indices: Vec<Index>,
     },
     ExtraTokenAfterLine {
         extra_token_pos: Pos,
@@ -209,141 +569,217 @@ pub enum ParseError {
 }
 
 impl ParseError {
-    pub fn eprint(self, file: &File) {
+    pub fn report(self, file: &File) {
         match self {
             ParseError::UnexpectedCharacter(index) => {
-                eprintln!("Unexpected character at {}.", index);
-                file.quote_index(index);
+                let mut diagnostic = Diagnostic::new(format!(
+                    "Unexpected character at {}.",
+                    file.display_index(index)
+                ));
+                diagnostic.quote_index(file, index);
+                diagnostic.report(file);
             }
             ParseError::UnterminatedStringLiteral { start_index } => {
-                eprintln!("Unterminated string literal started at {start_index}.");
-                file.quote_index(start_index);
+                let mut diagnostic = Diagnostic::new(format!(
+                    "Unterminated string literal started at {}.",
+                    file.display_index(start_index)
+                ));
+                diagnostic.quote_index(file, start_index);
+                diagnostic.report(file);
             }
             ParseError::InvalidEscapeSequence { backslash_index } => {
-                eprintln!("Invalid escape squence at {backslash_index}.");
-                file.quote_index(backslash_index);
+                let mut diagnostic = Diagnostic::new(format!(
+                    "Invalid escape squence at {}.",
+                    file.display_index(backslash_index)
+                ));
+                diagnostic.quote_index(file, backslash_index);
+                diagnostic.report(file);
             }
             ParseError::UnexpectedTokenInStringLiteral {
                 unexpected_token_pos,
                 dollar_index,
             } => {
-                eprintln!("Unexpected token at {unexpected_token_pos}.");
-                file.quote_pos(unexpected_token_pos);
-                eprintln!("Note: A placeholder in string literal started at {dollar_index}.");
-                file.quote_index(dollar_index);
+                let mut diagnostic = Diagnostic::new(format!(
+                    "Unexpected token at {}.",
+                    file.display_pos(&unexpected_token_pos)
+                ));
+                diagnostic.quote_pos(file, unexpected_token_pos);
+                diagnostic.note(format!(
+                    "Note: A placeholder in string literal started at {}.",
+                    file.display_index(dollar_index)
+                ));
+                diagnostic.quote_index(file, dollar_index);
+                diagnostic.report(file);
             }
             ParseError::UnterminatedComment {
                 start_indices: starts_index,
             } => {
-                eprintln!("Unterminated comment started at:");
+                let mut diagnostic =
+                    Diagnostic::new(String::from("Unterminated comment started at:"));
                 for start_index in starts_index {
-                    file.quote_index(start_index);
+                    diagnostic.quote_index(file, start_index);
                 }
+                diagnostic.report(file);
             }
             ParseError::InvalidBlockComment { start_index } => {
-                eprintln!(
+                let mut diagnostic = Diagnostic::new(String::from(
                     "A block comment must start at the beginning of the line, allowing only \
-                     leading whitespaces."
-                );
-                file.quote_index(start_index);
+                     leading whitespaces.",
+                ));
+                diagnostic.quote_index(file, start_index);
+                diagnostic.report(file);
             }
             ParseError::UnexpectedToken(unexpected_token_pos) => {
-                eprintln!("Unexpected token at {}.", unexpected_token_pos);
-                file.quote_pos(unexpected_token_pos);
+                let mut diagnostic = Diagnostic::new(format!(
+                    "Unexpected token at {}.",
+                    file.display_pos(&unexpected_token_pos)
+                ));
+                diagnostic.quote_pos(file, unexpected_token_pos);
+                diagnostic.report(file);
             }
             ParseError::UnexpectedTokenAfterKeywordStruct {
                 unexpected_token_pos,
                 keyword_struct_pos,
             } => {
-                eprintln!("Unexpected token at {}.", unexpected_token_pos);
-                file.quote_pos(unexpected_token_pos);
-                eprintln!(
+                let mut diagnostic = Diagnostic::new(format!(
+                    "Unexpected token at {}.",
+                    file.display_pos(&unexpected_token_pos)
+                ));
+                diagnostic.quote_pos(file, unexpected_token_pos);
+                diagnostic.note(format!(
                     "Expected an identifier after `struct` at {}.",
-                    keyword_struct_pos
-                );
-                file.quote_pos(keyword_struct_pos);
+                    file.display_pos(&keyword_struct_pos)
+                ));
+                diagnostic.quote_pos(file, keyword_struct_pos);
+                diagnostic.report(file);
             }
             ParseError::UnexpectedTokenAfterKeywordFunc {
                 unexpected_token_pos,
                 keyword_func_pos,
             } => {
-                eprintln!("Unexpected token at {}.", unexpected_token_pos);
-                file.quote_pos(unexpected_token_pos);
-                eprintln!(
+                let mut diagnostic = Diagnostic::new(format!(
+                    "Unexpected token at {}.",
+                    file.display_pos(&unexpected_token_pos)
+                ));
+                diagnostic.quote_pos(file, unexpected_token_pos);
+                diagnostic.note(format!(
                     "Expected an identifier after `func` at {}.",
-                    keyword_func_pos
-                );
-                file.quote_pos(keyword_func_pos);
+                    file.display_pos(&keyword_func_pos)
+                ));
+                diagnostic.quote_pos(file, keyword_func_pos);
+                diagnostic.report(file);
             }
             ParseError::ExtraTokenAfterLine {
                 extra_token_pos,
                 line_pos: _,
             } => {
-                eprintln!("An extra token at {}.", extra_token_pos);
-                file.quote_pos(extra_token_pos);
+                let mut diagnostic = Diagnostic::new(format!(
+                    "An extra token at {}.",
+                    file.display_pos(&extra_token_pos)
+                ));
+                diagnostic.quote_pos(file, extra_token_pos);
+                diagnostic.report(file);
             }
-            ParseError::UnclosedBlock { start_line_indices } => {
-                eprintln!("Unexpected end of file. Blocks opened at:");
-                for &line_index in &start_line_indices {
-                    file.quote_line(line_index);
+            ParseError::UnclosedBlock {
+                block_start_indices,
+            } => {
+                let mut diagnostic =
+                    Diagnostic::new(String::from("Unexpected end of file. Blocks opened at:"));
+                for &block_start_index in &block_start_indices {
+                    diagnostic.quote_line_containing(file, block_start_index);
                 }
+                diagnostic.report(file);
             }
             ParseError::UnexpectedTokenInBlock {
                 unexpected_token_pos,
-                start_line_indices,
+                block_start_indices,
             } => {
-                eprintln!("Unexpected token at {}.", unexpected_token_pos);
-                file.quote_pos(unexpected_token_pos);
-                eprintln!("Blocks opened at:");
-                for &line_index in &start_line_indices {
-                    file.quote_line(line_index);
+                let mut diagnostic = Diagnostic::new(format!(
+                    "Unexpected token at {}.",
+                    file.display_pos(&unexpected_token_pos)
+                ));
+                diagnostic.quote_pos(file, unexpected_token_pos);
+                diagnostic.note(String::from("Blocks opened at:"));
+                for &block_start_index in &block_start_indices {
+                    diagnostic.quote_line_containing(file, block_start_index);
                 }
+                diagnostic.report(file);
             }
             ParseError::MissingFieldAfterDot { dot_pos } => {
-                eprintln!("Missing field name or number after `.` at {dot_pos}.");
-                file.quote_pos(dot_pos);
+                let mut diagnostic = Diagnostic::new(format!(
+                    "Missing field name or number after `.` at {}.",
+                    file.display_pos(&dot_pos)
+                ));
+                diagnostic.quote_pos(file, dot_pos);
+                diagnostic.report(file);
             }
             ParseError::UnexpectedTokenAfterDot {
                 unexpected_token_pos,
                 dot_pos,
             } => {
-                eprintln!("Unexpected token at {}.", unexpected_token_pos);
-                file.quote_pos(unexpected_token_pos);
-                eprintln!("Note: expected a field name or number after `.` at {dot_pos}.");
-                file.quote_pos(dot_pos);
+                let mut diagnostic = Diagnostic::new(format!(
+                    "Unexpected token at {}.",
+                    file.display_pos(&unexpected_token_pos)
+                ));
+                diagnostic.quote_pos(file, unexpected_token_pos);
+                diagnostic.note(format!(
+                    "Note: expected a field name or number after `.` at {}.",
+                    file.display_pos(&dot_pos)
+                ));
+                diagnostic.quote_pos(file, dot_pos);
+                diagnostic.report(file);
             }
             ParseError::UnexpectedTokenInParentheses {
                 unexpected_token_pos,
                 opening_parenthesis_pos,
             } => {
-                eprintln!("Unexpected token at {}.", unexpected_token_pos);
-                file.quote_pos(unexpected_token_pos);
-                eprintln!("Note: opening parenthesis at {}.", opening_parenthesis_pos);
-                file.quote_pos(opening_parenthesis_pos);
+                let mut diagnostic = Diagnostic::new(format!(
+                    "Unexpected token at {}.",
+                    file.display_pos(&unexpected_token_pos)
+                ));
+                diagnostic.quote_pos(file, unexpected_token_pos);
+                diagnostic.note(format!(
+                    "Note: opening parenthesis at {}.",
+                    file.display_pos(&opening_parenthesis_pos)
+                ));
+                diagnostic.quote_pos(file, opening_parenthesis_pos);
+                diagnostic.report(file);
             }
             ParseError::UnclosedParenthesis {
                 opening_parenthesis_pos,
             } => {
-                eprintln!(
+                let mut diagnostic = Diagnostic::new(format!(
                     "Unclosed parenthesis opened at {}.",
-                    opening_parenthesis_pos
-                );
-                file.quote_pos(opening_parenthesis_pos);
+                    file.display_pos(&opening_parenthesis_pos)
+                ));
+                diagnostic.quote_pos(file, opening_parenthesis_pos);
+                diagnostic.report(file);
             }
             ParseError::UnexpectedTokenInBrackets {
                 unexpected_token_pos,
                 opening_bracket_pos,
             } => {
-                eprintln!("Unexpected token at {}.", unexpected_token_pos);
-                file.quote_pos(unexpected_token_pos);
-                eprintln!("Note: opening bracket at {}.", opening_bracket_pos);
-                file.quote_pos(opening_bracket_pos);
+                let mut diagnostic = Diagnostic::new(format!(
+                    "Unexpected token at {}.",
+                    file.display_pos(&unexpected_token_pos)
+                ));
+                diagnostic.quote_pos(file, unexpected_token_pos);
+                diagnostic.note(format!(
+                    "Note: opening bracket at {}.",
+                    file.display_pos(&opening_bracket_pos)
+                ));
+                diagnostic.quote_pos(file, opening_bracket_pos);
+                diagnostic.report(file);
             }
             ParseError::UnclosedBracket {
                 opening_bracket_pos,
             } => {
-                eprintln!("Unclosed bracket opened at {}.", opening_bracket_pos);
-                file.quote_pos(opening_bracket_pos);
+                let mut diagnostic = Diagnostic::new(format!(
+                    "Unclosed bracket opened at {}.",
+                    file.display_pos(&opening_bracket_pos)
+                ));
+                diagnostic.quote_pos(file, opening_bracket_pos);
+                diagnostic.report(file);
             }
         }
     }
@@ -355,37 +791,56 @@ pub struct Pos {
     pub end: Index,
 }
 
-impl Pos {
-    pub fn line(&self) -> usize {
-        self.start.line
-    }
-}
-
-impl Display for Pos {
-    fn fmt(&self, f: &mut Formatter) -> fmt::Result {
-        self.start.fmt_start(f)?;
-        write!(f, "-")?;
-        self.end.fmt_end(f)
-    }
-}
-
+/**
+ * A position in a source file, as a plain byte offset from the start. The
+ * parser only ever records byte offsets; line and column numbers are
+ * recovered lazily by [`File`] when a diagnostic is printed.
+ *
+ * The offset is a `u32`, so a [`Pos`] is a single word and every token and
+ * AST node carries half the position data it would with native offsets; a
+ * single source file is limited to 4 GiB, enforced when its
+ * [`CharsPeekable`](crate::frontend::chars_peekable::CharsPeekable) is
+ * created.
+ */
 #[derive(Clone, Copy, PartialEq, Eq, Debug)]
 pub struct Index {
-    pub line: usize,
-    pub column: usize,
+    pub byte: u32,
+}
+
+/**
+ * An [`Index`] resolved to line and column numbers by
+ * [`File::display_index`], for use in messages.
+ */
+pub struct IndexDisplay {
+    line: usize,
+    column: usize,
 }
 
-impl Index {
-    fn fmt_start(&self, f: &mut Formatter) -> fmt::Result {
+impl Display for IndexDisplay {
+    fn fmt(&self, f: &mut Formatter) -> fmt::Result {
         write!(f, "{}:{}", self.line + 1, self.column + 1)
     }
-    fn fmt_end(&self, f: &mut Formatter) -> fmt::Result {
-        write!(f, "{}:{}", self.line + 1, self.column)
-    }
 }
 
-impl Display for Index {
+/**
+ * A [`Pos`] resolved to line and column numbers by [`File::display_pos`],
+ * for use in messages. The start is shown 1-based and inclusive, the end
+ * exclusive.
+ */
+pub struct PosDisplay {
+    start: (usize, usize),
+    end: (usize, usize),
+}
+
+impl Display for PosDisplay {
     fn fmt(&self, f: &mut Formatter) -> fmt::Result {
-        self.fmt_start(f)
+        write!(
+            f,
+            "{}:{}-{}:{}",
+            self.start.0 + 1,
+            self.start.1 + 1,
+            self.end.0 + 1,
+            self.end.1,
+        )
     }
 }
@@ -16,24 +16,212 @@
  * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
  */
 
-mod backend;
-mod frontend;
-mod log;
-
+use std::io::{BufRead, Write};
 use std::process::ExitCode;
 
-use clap::Parser;
+use clap::{CommandFactory, Parser};
+
+use syscraws::{frontend, log, stats};
 
 #[derive(Parser)]
 struct CommandLineArguments {
-    filename: String,
+    /**
+     * The entry points to compile. Several entry points are compiled
+     * concurrently in one process, sharing the parsed modules of their
+     * common imports.
+     */
+    #[arg(required_unless_present = "server", num_args = 1..)]
+    filenames: Vec<String>,
+    /**
+     * Report phase timings and allocation counters as JSON on standard
+     * error.
+     */
+    #[arg(long)]
+    time_passes: bool,
+    /**
+     * Report diagnostics as one JSON object per line instead of the
+     * human-readable format.
+     */
+    #[arg(long)]
+    json_diagnostics: bool,
+    /**
+     * Run as a long-lived server: read one root file path per line from
+     * standard input, compile it, and answer `ok <path>` or `error <path>`
+     * on standard output. Parsed modules of shared imports stay resident
+     * between requests.
+     */
+    #[arg(long)]
+    server: bool,
+    /**
+     * Recompile whenever a file of the import closure changes: compile
+     * once, then poll the discovered files and rebuild on modification.
+     * Unchanged files replay from their module caches, so a rebuild costs
+     * roughly the changed file and its reverse dependencies.
+     */
+    #[arg(long, conflicts_with = "server")]
+    watch: bool,
 }
 
 fn main() -> ExitCode {
     let command_line_arguments = CommandLineArguments::parse();
-    let Ok(_) = frontend::read_input(std::path::Path::new(&command_line_arguments.filename)) else {
+    if command_line_arguments.time_passes {
+        stats::enable();
+    }
+    if command_line_arguments.json_diagnostics {
+        log::set_format(log::Format::Json);
+    }
+    if command_line_arguments.server {
+        return serve();
+    }
+    let filenames = command_line_arguments.filenames;
+    if command_line_arguments.watch {
+        if filenames.len() > 1 {
+            CommandLineArguments::command()
+                .error(
+                    clap::error::ErrorKind::ArgumentConflict,
+                    "'--watch' takes a single entry point",
+                )
+                .exit();
+        }
+        return watch(&filenames[0]);
+    }
+    if filenames.len() > 1 {
+        return compile_batch(&filenames);
+    }
+    let result = frontend::read_input(std::path::Path::new(&filenames[0]));
+    stats::report();
+    let Ok(_) = result else {
         return ExitCode::FAILURE;
     };
 
     ExitCode::SUCCESS
 }
+
+/**
+ * Compiles every entry point in `filenames` concurrently, one compilation
+ * per worker at a time, all sharing one [`frontend::Session`]: the first
+ * compilation to reach a shared import parses and translates it, the rest
+ * replay its module cache. Reports `ok <path>` or `error <path>` per entry
+ * point, like the server mode; diagnostics of concurrent compilations may
+ * interleave on standard error. Fails if any entry point fails.
+ */
+fn compile_batch(filenames: &[String]) -> ExitCode {
+    use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+
+    let session = frontend::Session::new();
+    let next = AtomicUsize::new(0);
+    let failed = AtomicBool::new(false);
+    let num_workers = std::thread::available_parallelism()
+        .map_or(1, std::num::NonZero::get)
+        .min(filenames.len());
+    std::thread::scope(|scope| {
+        for _ in 0..num_workers {
+            scope.spawn(|| loop {
+                let index = next.fetch_add(1, Ordering::Relaxed);
+                let Some(filename) = filenames.get(index) else {
+                    return;
+                };
+                let result = session.compile(std::path::Path::new(filename));
+                if result.is_err() {
+                    failed.store(true, Ordering::Relaxed);
+                }
+                let status = if result.is_ok() { "ok" } else { "error" };
+                let mut stdout = std::io::stdout().lock();
+                let _ = writeln!(stdout, "{status} {filename}").and_then(|_| stdout.flush());
+            });
+        }
+    });
+    stats::report();
+    if failed.load(Ordering::Relaxed) {
+        ExitCode::FAILURE
+    } else {
+        ExitCode::SUCCESS
+    }
+}
+
+/**
+ * The polling interval of [`watch`]: short enough that an edit is picked
+ * up well within the feedback budget of an interactive check.
+ */
+const WATCH_INTERVAL: std::time::Duration = std::time::Duration::from_millis(50);
+
+/**
+ * The `--watch` loop: compile, report `ok <path>` or `error <path>`, then
+ * poll the modification times of every file the compilation discovered
+ * and recompile as soon as one changes. The shared
+ * [`frontend::Session`] keeps module caches of unchanged files warm, so
+ * each rebuild re-parses and re-translates only the changed file and its
+ * reverse dependencies in the import DAG. Runs until the process is
+ * interrupted.
+ */
+fn watch(filename: &str) -> ExitCode {
+    let session = frontend::Session::new();
+    let root = std::path::Path::new(filename);
+    loop {
+        let (result, watched_files) = session.compile_watched(root);
+        let status = if result.is_ok() { "ok" } else { "error" };
+        let mut stdout = std::io::stdout().lock();
+        if writeln!(stdout, "{status} {filename}")
+            .and_then(|_| stdout.flush())
+            .is_err()
+        {
+            return ExitCode::FAILURE;
+        }
+        drop(stdout);
+        let stamps: Vec<_> = watched_files.iter().map(|path| modified(path)).collect();
+        loop {
+            std::thread::sleep(WATCH_INTERVAL);
+            if watched_files
+                .iter()
+                .zip(&stamps)
+                .any(|(path, stamp)| modified(path) != *stamp)
+            {
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * The modification time of the file at `path`, or `None` if it cannot be
+ * read, so deleting or recreating a file triggers a rebuild.
+ */
+fn modified(path: &std::path::Path) -> Option<std::time::SystemTime> {
+    std::fs::metadata(path)
+        .and_then(|metadata| metadata.modified())
+        .ok()
+}
+
+/**
+ * The `--server` loop: one compilation per input line, sharing a
+ * [`frontend::Session`] so module caches stay warm, until standard input
+ * reaches end of file.
+ */
+fn serve() -> ExitCode {
+    let session = frontend::Session::new();
+    let stdin = std::io::stdin();
+    let mut line = String::new();
+    loop {
+        line.clear();
+        match stdin.lock().read_line(&mut line) {
+            Ok(0) => break,
+            Ok(_) => {}
+            Err(_) => return ExitCode::FAILURE,
+        }
+        let path = line.trim();
+        if path.is_empty() {
+            continue;
+        }
+        let result = session.compile(std::path::Path::new(path));
+        let status = if result.is_ok() { "ok" } else { "error" };
+        let mut stdout = std::io::stdout().lock();
+        if writeln!(stdout, "{status} {path}")
+            .and_then(|_| stdout.flush())
+            .is_err()
+        {
+            return ExitCode::FAILURE;
+        }
+    }
+    stats::report();
+    ExitCode::SUCCESS
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * Defines [`Source`], a zero-copy buffer holding the contents of one source
+ * file.
+ *
+ * The file is memory-mapped instead of being copied into a fresh `String`,
+ * and the same buffer is borrowed by the parser and sliced by diagnostics
+ * ([`File`](crate::log::File)), so each file is resident in memory exactly
+ * once.
+ */
+
+use std::ops::Deref;
+use std::path::Path;
+
+/**
+ * The contents of one source file, validated as UTF-8.
+ */
+pub struct Source {
+    bytes: Bytes,
+}
+
+enum Bytes {
+    /**
+     * The common case: the file is memory-mapped.
+     */
+    Mapped(memmap2::Mmap),
+    /**
+     * Fallback for files that cannot be mapped (e.g. empty files).
+     */
+    Owned(String),
+}
+
+impl Source {
+    /**
+     * Opens and memory-maps the file at `path`. Returns an
+     * [`InvalidData`](std::io::ErrorKind::InvalidData) error if the
+     * contents are not valid UTF-8.
+     */
+    pub fn read(path: &Path) -> std::io::Result<Source> {
+        let file = std::fs::File::open(path)?;
+        if file.metadata()?.len() == 0 {
+            return Ok(Source {
+                bytes: Bytes::Owned(String::new()),
+            });
+        }
+        // SAFETY: the mapping is valid as long as no other process truncates
+        // the file while the compiler runs; modifying sources mid-compile
+        // yields garbage diagnostics either way.
+        let map = match unsafe { memmap2::Mmap::map(&file) } {
+            Ok(map) => map,
+            Err(_) => {
+                // Not a mappable file; fall back to an owned copy.
+                let content = std::fs::read_to_string(path)?;
+                return Ok(Source {
+                    bytes: Bytes::Owned(content),
+                });
+            }
+        };
+        if std::str::from_utf8(&map).is_err() {
+            return Err(std::io::Error::new(
+                std::io::ErrorKind::InvalidData,
+                "stream did not contain valid UTF-8",
+            ));
+        }
+        Ok(Source {
+            bytes: Bytes::Mapped(map),
+        })
+    }
+}
+
+impl Source {
+    /**
+     * An empty buffer, used when the file could not be read at all.
+     */
+    pub fn empty() -> Source {
+        Source {
+            bytes: Bytes::Owned(String::new()),
+        }
+    }
+}
+
+impl std::ops::Index<std::ops::Range<usize>> for Source {
+    type Output = str;
+
+    fn index(&self, range: std::ops::Range<usize>) -> &str {
+        &self.deref()[range]
+    }
+}
+
+impl Deref for Source {
+    type Target = str;
+
+    fn deref(&self) -> &str {
+        match &self.bytes {
+            // The contents were validated as UTF-8 in `read`.
+            Bytes::Mapped(map) => unsafe { std::str::from_utf8_unchecked(map) },
+            Bytes::Owned(content) => content,
+        }
+    }
+}
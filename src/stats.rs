@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2023-2025 Atsushi Komaba
+ *
+ * This file is part of Syscraws.
+ * Syscraws is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 3
+ * of the License, or any later version.
+ *
+ * Syscraws is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Syscraws. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*!
+ * Compile-time instrumentation behind the `--time-passes` flag.
+ *
+ * Counters and timers live in process-wide atomics so that the parallel
+ * parse workers and the sequential translation can report into the same
+ * place; everything is a no-op until [`enable`] is called. [`report`]
+ * prints one line of JSON to standard error, so regressions can be tracked
+ * mechanically across compiler versions.
+ */
+
+use std::path::Path;
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::Mutex;
+use std::time::{Duration, Instant};
+
+static ENABLED: AtomicBool = AtomicBool::new(false);
+
+/**
+ * Turns instrumentation on for the rest of the process.
+ */
+pub fn enable() {
+    ENABLED.store(true, Ordering::Relaxed);
+}
+
+fn enabled() -> bool {
+    ENABLED.load(Ordering::Relaxed)
+}
+
+/**
+ * An event counted during compilation.
+ */
+#[derive(Clone, Copy)]
+pub enum Counter {
+    TokensLexed,
+    TermsAllocated,
+    TyCellsCreated,
+    UnifyCalls,
+    RollbackCalls,
+}
+
+const COUNTER_NAMES: [&str; 5] = [
+    "tokens_lexed",
+    "terms_allocated",
+    "ty_cells_created",
+    "unify_calls",
+    "rollback_calls",
+];
+
+static COUNTERS: [AtomicU64; 5] = [
+    AtomicU64::new(0),
+    AtomicU64::new(0),
+    AtomicU64::new(0),
+    AtomicU64::new(0),
+    AtomicU64::new(0),
+];
+
+/**
+ * Adds `amount` occurrences of `counter`.
+ */
+pub fn count(counter: Counter, amount: u64) {
+    if enabled() {
+        COUNTERS[counter as usize].fetch_add(amount, Ordering::Relaxed);
+    }
+}
+
+/**
+ * A compilation phase whose total duration is accumulated.
+ */
+#[derive(Clone, Copy)]
+pub enum Phase {
+    TranslateStructureDefinitions,
+    TranslateFunctionDefinitions,
+    TranslateStatements,
+    Resolve,
+    Inline,
+    Hoist,
+}
+
+const PHASE_NAMES: [&str; 6] = [
+    "translate_structure_definitions",
+    "translate_function_definitions",
+    "translate_statements",
+    "resolve",
+    "inline",
+    "hoist",
+];
+
+static PHASE_NANOSECONDS: [AtomicU64; 6] = [
+    AtomicU64::new(0),
+    AtomicU64::new(0),
+    AtomicU64::new(0),
+    AtomicU64::new(0),
+    AtomicU64::new(0),
+    AtomicU64::new(0),
+];
+
+/**
+ * Runs `f`, adding its duration to the total for `phase`.
+ */
+pub fn time<T>(phase: Phase, f: impl FnOnce() -> T) -> T {
+    if !enabled() {
+        return f();
+    }
+    let start = Instant::now();
+    let result = f();
+    PHASE_NANOSECONDS[phase as usize]
+        .fetch_add(start.elapsed().as_nanos() as u64, Ordering::Relaxed);
+    result
+}
+
+static PARSE_TIMES: Mutex<Vec<(String, u64)>> = Mutex::new(Vec::new());
+
+/**
+ * Records that parsing the file at `path` took `duration`.
+ */
+pub fn record_parse(path: &Path, duration: Duration) {
+    if !enabled() {
+        return;
+    }
+    PARSE_TIMES.lock().unwrap().push((
+        path.to_string_lossy().into_owned(),
+        duration.as_nanos() as u64,
+    ));
+}
+
+/**
+ * Prints everything recorded so far as one JSON object on standard error.
+ */
+pub fn report() {
+    if !enabled() {
+        return;
+    }
+    let mut output = String::from("{\"parse\":[");
+    let parse_times = PARSE_TIMES.lock().unwrap();
+    for (i, (path, nanoseconds)) in parse_times.iter().enumerate() {
+        if i > 0 {
+            output.push(',');
+        }
+        output.push_str("{\"file\":\"");
+        for c in path.chars() {
+            match c {
+                '"' | '\\' => {
+                    output.push('\\');
+                    output.push(c);
+                }
+                '\n' => output.push_str("\\n"),
+                _ => output.push(c),
+            }
+        }
+        output.push_str(&format!("\",\"nanoseconds\":{}}}", nanoseconds));
+    }
+    output.push_str("],\"phases\":{");
+    for (i, name) in PHASE_NAMES.iter().enumerate() {
+        if i > 0 {
+            output.push(',');
+        }
+        output.push_str(&format!(
+            "\"{}\":{}",
+            name,
+            PHASE_NANOSECONDS[i].load(Ordering::Relaxed)
+        ));
+    }
+    output.push_str("},\"counters\":{");
+    for (i, name) in COUNTER_NAMES.iter().enumerate() {
+        if i > 0 {
+            output.push(',');
+        }
+        output.push_str(&format!(
+            "\"{}\":{}",
+            name,
+            COUNTERS[i].load(Ordering::Relaxed)
+        ));
+    }
+    output.push_str("}}");
+    eprintln!("{}", output);
+}